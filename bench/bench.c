@@ -0,0 +1,425 @@
+/**
+ * @file bench.c
+ * @brief This file contains the off-hardware render benchmark for PCD8544 display.
+ * @author Sk. Mohammadul Haque
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/PCD8544.h"
+#include "bench.h"
+
+/*
+ * Every workload runs against the mock backend. Each one is timed on its
+ * own (drawing only, no transfer) for ns/call and pixels/s, then replayed
+ * with an LCDupdate after every call to measure what reaches the wire.
+ * Pixels are the nominal number written per call.
+ *
+ * Usage: bench [iterations]
+ *        bench --verify [cases]
+ *        bench --dump DIR
+ *        bench --golden DIR
+ *
+ * --verify cross-checks the primitives against reference rasterizers,
+ * --dump writes the golden scenes as PBM images and --golden compares the
+ * current output against them. All three exit non-zero on a mismatch.
+ */
+
+#define UPDATE_ROUNDS 200
+
+typedef struct
+{
+    const char *name;
+    void (*run)(pcd8544_t *lcd, uint32_t i);
+    uint32_t (*pixels)(uint32_t i);
+} workload_t;
+
+static uint8_t sprite[16*16/8];
+static uint8_t frames[8][LCD_FRAME_MAXSIZE];
+static uint16_t frame_sizes[8];
+static uint8_t widget_buffer[LCD_CANVAS_SIZE(40, 16)];
+static pcd8544_canvas_t widget;
+static pcd8544_scene_t scene;
+static pcd8544_widget_t counter;
+static uint8_t photo[160*120*3];
+
+/* a boxed label over a small chart, drawn from primitives */
+static void draw_widget(const pcd8544_canvas_t *c, int16_t x, int16_t y)
+{
+    uint8_t i;
+    LCDcanvasFillrect(c, x, y, 40, 16, WHITE);
+    LCDcanvasDrawrect(c, x, y, 40, 16, BLACK);
+    LCDcanvasDrawstring(c, x+2, y+2, "CPU 42", NULL, 1, BLACK);
+    for(i=0; i<6; ++i) LCDcanvasDrawline(c, x+2+i*6, y+13-(i*5)%4, x+8+i*6, y+13-((i+1)*5)%4, BLACK);
+}
+
+uint32_t bench_rnd(uint32_t i, uint32_t k)
+{
+    uint32_t x = i*2654435761UL+k*40503UL;
+    x ^= x>>15;
+    x *= 2246822519UL;
+    x ^= x>>13;
+    return x;
+}
+
+static uint64_t nsnow(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000000000ULL+t.tv_nsec;
+}
+
+static void run_pixel(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_setPixel(lcd, bench_rnd(i, 1)%LCDWIDTH, bench_rnd(i, 2)%LCDHEIGHT, i&1);
+}
+
+static uint32_t px_one(uint32_t i)
+{
+    (void)i;
+    return 1;
+}
+
+static void run_hline(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_drawhline(lcd, 0, bench_rnd(i, 1)%LCDHEIGHT, LCDWIDTH, i&1);
+}
+
+static uint32_t px_hline(uint32_t i)
+{
+    (void)i;
+    return LCDWIDTH;
+}
+
+static void run_vline(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_drawvline(lcd, bench_rnd(i, 1)%LCDWIDTH, 0, LCDHEIGHT, i&1);
+}
+
+static uint32_t px_vline(uint32_t i)
+{
+    (void)i;
+    return LCDHEIGHT;
+}
+
+static void run_line(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_drawline(lcd, bench_rnd(i, 1)%LCDWIDTH, bench_rnd(i, 2)%LCDHEIGHT, bench_rnd(i, 3)%LCDWIDTH, bench_rnd(i, 4)%LCDHEIGHT, i&1);
+}
+
+static uint32_t px_line(uint32_t i)
+{
+    int32_t dx = (int32_t)(bench_rnd(i, 3)%LCDWIDTH)-(int32_t)(bench_rnd(i, 1)%LCDWIDTH);
+    int32_t dy = (int32_t)(bench_rnd(i, 4)%LCDHEIGHT)-(int32_t)(bench_rnd(i, 2)%LCDHEIGHT);
+    if(dx<0) dx = -dx;
+    if(dy<0) dy = -dy;
+    return ((dx>dy)?dx:dy)+1;
+}
+
+static void run_clipline(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_canvas_t screen;
+    int16_t y = (int16_t)(bench_rnd(i, 2)%LCDHEIGHT);
+    pcd8544_getcanvas(lcd, &screen);
+    LCDcanvasDrawline(&screen, -2000, y-20, LCDWIDTH+2000, y+21, i&1);
+    pcd8544_invalidate(lcd, 0, 0, LCDWIDTH, LCDHEIGHT);
+}
+
+static uint32_t px_clipline(uint32_t i)
+{
+    (void)i;
+    return LCDWIDTH;
+}
+
+static void run_rect(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_drawrect(lcd, bench_rnd(i, 1)%(LCDWIDTH-24), bench_rnd(i, 2)%(LCDHEIGHT-16), 24, 16, i&1);
+}
+
+static uint32_t px_rect(uint32_t i)
+{
+    (void)i;
+    return 2*24+2*16-4;
+}
+
+static void run_fillrect(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_fillrect(lcd, bench_rnd(i, 1)%(LCDWIDTH-24), bench_rnd(i, 2)%(LCDHEIGHT-16), 24, 16, i&1);
+}
+
+static uint32_t px_fillrect(uint32_t i)
+{
+    (void)i;
+    return 24*16;
+}
+
+static void run_circle(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_drawcircle(lcd, 12+bench_rnd(i, 1)%(LCDWIDTH-24), 12+bench_rnd(i, 2)%(LCDHEIGHT-24), 11, i&1);
+}
+
+static uint32_t px_circle(uint32_t i)
+{
+    (void)i;
+    return 69; /* 2*pi*11 */
+}
+
+static void run_fillcircle(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_fillcircle(lcd, 12+bench_rnd(i, 1)%(LCDWIDTH-24), 12+bench_rnd(i, 2)%(LCDHEIGHT-24), 11, i&1);
+}
+
+static uint32_t px_fillcircle(uint32_t i)
+{
+    (void)i;
+    return 380; /* pi*11*11 */
+}
+
+/* a gauge needle sweeping from a fixed hub */
+static void run_needle(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_filltriangle(lcd, LCDWIDTH/2-2, LCDHEIGHT-4, LCDWIDTH/2+2, LCDHEIGHT-4, 2+i%(LCDWIDTH-4), 4, i&1);
+}
+
+static uint32_t px_needle(uint32_t i)
+{
+    (void)i;
+    return 4*(LCDHEIGHT-8)/2;
+}
+
+static void run_roundrect(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_fillroundrect(lcd, bench_rnd(i, 1)%(LCDWIDTH-24), bench_rnd(i, 2)%(LCDHEIGHT-16), 24, 16, 4, i&1);
+}
+
+static void run_sprite(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_blitbitmap(lcd, (int16_t)(bench_rnd(i, 1)%(LCDWIDTH+16))-16, (int16_t)(bench_rnd(i, 2)%(LCDHEIGHT+16))-16, sprite, 16, 16, LCD_ROP_XOR);
+}
+
+static uint32_t px_sprite(uint32_t i)
+{
+    (void)i;
+    return 16*16;
+}
+
+static void run_bitmap(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_drawbitmap(lcd, bench_rnd(i, 1)%(LCDWIDTH-16), bench_rnd(i, 2)%(LCDHEIGHT-16), sprite, 16, 16, i&1);
+}
+
+static void run_text1(pcd8544_t *lcd, uint32_t i)
+{
+    uint8_t r;
+    pcd8544_setTextSize(lcd, 1);
+    pcd8544_setTextColor(lcd, (i&1)?WHITE:BLACK);
+    for(r=0; r<6; ++r) pcd8544_drawstring(lcd, 0, r*8, "The quick fox!");
+}
+
+static uint32_t px_text1(uint32_t i)
+{
+    (void)i;
+    return LCDWIDTH*LCDHEIGHT;
+}
+
+static void run_text2(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_setTextSize(lcd, 2);
+    pcd8544_setTextColor(lcd, (i&1)?WHITE:BLACK);
+    pcd8544_drawstring(lcd, 0, 16, "12:34:5");
+    pcd8544_setTextSize(lcd, 1);
+}
+
+static uint32_t px_text2(uint32_t i)
+{
+    (void)i;
+    return 7*12*16;
+}
+
+static void run_label(pcd8544_t *lcd, uint32_t i)
+{
+    char s[8];
+    pcd8544_setTextSize(lcd, 1);
+    pcd8544_setTextColor(lcd, BLACK);
+    sprintf(s, "%5u", (unsigned)(i%100000));
+    pcd8544_drawstring(lcd, 54, 40, s);
+}
+
+static uint32_t px_label(uint32_t i)
+{
+    (void)i;
+    return 5*6*8;
+}
+
+static void run_frame(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_drawframe(lcd, frames[i&7], frame_sizes[i&7]);
+}
+
+/* the same counter as a retained label that only changes every 16th call */
+static void run_scene(pcd8544_t *lcd, uint32_t i)
+{
+    if(!i) LCDsceneInvalidate(&scene);
+    LCDlabelSetNumber(&counter, i>>4);
+    pcd8544_sceneRender(lcd, &scene);
+}
+
+static uint32_t px_frame(uint32_t i)
+{
+    (void)i;
+    return LCDWIDTH*LCDHEIGHT;
+}
+
+static void run_widget(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_canvas_t screen;
+    int16_t x = bench_rnd(i, 1)%(LCDWIDTH-40), y = bench_rnd(i, 2)%(LCDHEIGHT-16);
+    pcd8544_getcanvas(lcd, &screen);
+    draw_widget(&screen, x, y);
+    pcd8544_invalidate(lcd, x, y, 40, 16);
+}
+
+static void run_cached_widget(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_blitcanvas(lcd, bench_rnd(i, 1)%(LCDWIDTH-40), bench_rnd(i, 2)%(LCDHEIGHT-16), &widget, 0, 0, 40, 16, LCD_ROP_COPY);
+}
+
+static uint32_t px_widget(uint32_t i)
+{
+    (void)i;
+    return 40*16;
+}
+
+static void run_image_bayer(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_drawimage(lcd, 0, 0, 0, 0, photo+(i&7), LCDWIDTH, LCDHEIGHT, 0, LCD_DITHER_GRAY, LCD_DITHER_BAYER);
+}
+
+static void run_image_floyd(pcd8544_t *lcd, uint32_t i)
+{
+    pcd8544_drawimage(lcd, 0, 0, 0, 0, photo, 160-(i&1), 120, 160*3, LCD_DITHER_RGB, LCD_DITHER_FLOYD);
+}
+
+static void run_clear(pcd8544_t *lcd, uint32_t i)
+{
+    (void)i;
+    pcd8544_zero(lcd);
+}
+
+static const workload_t workloads[] =
+{
+    {"setpixel", run_pixel, px_one},
+    {"drawhline", run_hline, px_hline},
+    {"drawvline", run_vline, px_vline},
+    {"drawline", run_line, px_line},
+    {"drawline_clipped", run_clipline, px_clipline},
+    {"drawrect", run_rect, px_rect},
+    {"fillrect", run_fillrect, px_fillrect},
+    {"drawcircle", run_circle, px_circle},
+    {"fillcircle", run_fillcircle, px_fillcircle},
+    {"filltriangle_needle", run_needle, px_needle},
+    {"fillroundrect", run_roundrect, px_fillrect},
+    {"sprite_xor_16x16", run_sprite, px_sprite},
+    {"drawbitmap_16x16", run_bitmap, px_sprite},
+    {"text_fullscreen_size1", run_text1, px_text1},
+    {"text_size2", run_text2, px_text2},
+    {"text_label_partial", run_label, px_label},
+    {"scene_label_steady", run_scene, px_label},
+    {"frame_delta", run_frame, px_frame},
+    {"widget_40x16_primitives", run_widget, px_widget},
+    {"widget_40x16_cached", run_cached_widget, px_widget},
+    {"image_84x48_bayer", run_image_bayer, px_text1},
+    {"image_160x120_rgb_floyd", run_image_floyd, px_text1},
+    {"zero", run_clear, px_text1},
+};
+
+static void setup(void)
+{
+    uint8_t raw[2][LCDWIDTH*LCDHEIGHT/8];
+    uint16_t i, k;
+    for(i=0; i<sizeof(sprite); ++i) sprite[i] = bench_rnd(i, 7);
+    for(i=0; i<sizeof(photo); ++i) photo[i] = (uint8_t)(i/3%160+(i/480)+bench_rnd(i, 11)%16);
+    LCDcanvasInit(&widget, widget_buffer, 40, 16, 0);
+    draw_widget(&widget, 0, 0);
+    LCDsceneInit(&scene);
+    LCDlabelInit(&counter, 54, 40, 30, 8, NULL, 1);
+    LCDsceneAdd(&scene, &counter);
+    memset(raw[0], 0, sizeof(raw[0]));
+    for(k=0; k<8; ++k)
+    {
+        memcpy(raw[1], raw[0], sizeof(raw[0]));
+        for(i=0; i<40; ++i) raw[1][bench_rnd(k*40+i, 9)%sizeof(raw[1])] = bench_rnd(k*40+i, 10);
+        frame_sizes[k] = LCDencodeFrame(raw[1], k?raw[0]:NULL, frames[k], LCD_FRAME_MAXSIZE);
+        memcpy(raw[0], raw[1], sizeof(raw[0]));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations, i;
+    pcd8544_transport_t t;
+    pcd8544_mock_t m;
+    pcd8544_t *lcd;
+    uint64_t t0, ns, pixels;
+    size_t w;
+    if((argc>1)&&!strcmp(argv[1], "--verify")) return bench_verify((argc>2)?(uint32_t)strtoul(argv[2], NULL, 10):100000)?1:0;
+    if((argc>2)&&!strcmp(argv[1], "--dump")) return bench_golden(argv[2], 1)?1:0;
+    if((argc>2)&&!strcmp(argv[1], "--golden")) return bench_golden(argv[2], 0)?1:0;
+    iterations = (argc>1)?(uint32_t)strtoul(argv[1], NULL, 10):100000;
+    if(!iterations) iterations = 1;
+    setup();
+    lcd = pcd8544_create();
+    if(lcd==NULL) return 1;
+    LCDmockTransport(&t, &m);
+    pcd8544_inittransport(lcd, &t, LCD_CONTRAST);
+
+    printf("{\n  \"iterations\": %u,\n  \"update_rounds\": %u,\n  \"results\": [\n", iterations, UPDATE_ROUNDS);
+    for(w=0; w<sizeof(workloads)/sizeof(workloads[0]); ++w)
+    {
+        const workload_t *wl = workloads+w;
+        pcd8544_zero(lcd);
+        pcd8544_update(lcd);
+        for(i=0, pixels=0; i<iterations; ++i) pixels += wl->pixels(i);
+        t0 = nsnow();
+        for(i=0; i<iterations; ++i) wl->run(lcd, i);
+        ns = nsnow()-t0;
+        if(!ns) ns = 1;
+
+        pcd8544_zero(lcd);
+        pcd8544_update(lcd);
+        LCDmockClear(&m);
+        for(i=0; i<UPDATE_ROUNDS; ++i)
+        {
+            wl->run(lcd, i);
+            pcd8544_update(lcd);
+        }
+        printf("    {\"name\": \"%s\", \"calls\": %u, \"ns_per_call\": %.1f, \"pixels_per_s\": %.0f, "
+               "\"update\": {\"data_bytes\": %.1f, \"command_bytes\": %.1f, \"transactions\": %.2f, \"dc_toggles\": %.2f, \"flushes\": %.2f}}%s\n",
+               wl->name, iterations, (double)ns/iterations, (double)pixels*1e9/ns,
+               (double)m.data_bytes/UPDATE_ROUNDS, (double)m.command_bytes/UPDATE_ROUNDS,
+               (double)m.transactions/UPDATE_ROUNDS, (double)m.dc_toggles/UPDATE_ROUNDS, (double)m.flushes/UPDATE_ROUNDS,
+               ((w+1)<sizeof(workloads)/sizeof(workloads[0]))?",":"");
+    }
+    printf("  ]\n}\n");
+    pcd8544_destroy(lcd);
+    return 0;
+}
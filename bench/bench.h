@@ -0,0 +1,32 @@
+/**
+ * @file bench.h
+ * @brief This file contains the shared declarations of the PCD8544 benchmark.
+ * @author Sk. Mohammadul Haque
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <inttypes.h>
+
+uint32_t bench_rnd(uint32_t i, uint32_t k);
+int bench_verify(uint32_t cases);
+int bench_golden(const char *dir, int write);
+
+#endif
@@ -0,0 +1,1187 @@
+/**
+ * @file verify.c
+ * @brief This file contains the reference cross-check and golden scenes of the PCD8544 benchmark.
+ * @author Sk. Mohammadul Haque
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <time.h>
+#include "../include/PCD8544.h"
+#include "bench.h"
+
+/*
+ * The reference rasterizers below plot one clipped pixel at a time with the
+ * textbook algorithms the library started from. Every optimized primitive
+ * must match them bit for bit, over a random background, including shapes
+ * hanging off any edge. After each case the mock's RAM must also equal the
+ * buffer, which checks that the dirty tracking covered every change.
+ *
+ * The checks after them exercise the stateful layers (queue, async
+ * flushing, diff mode, frame codec, player, widgets) against the mock and
+ * count the expectations that failed.
+ */
+
+#define OPS 19
+
+static const char *op_names[OPS] =
+{
+    "setpixel", "drawhline", "drawvline", "drawline", "drawrect", "fillrect",
+    "drawcircle", "fillcircle", "drawbitmap", "blitbitmap", "drawchar", "drawbitframe",
+    "blitcanvas", "canvas", "filltriangle", "fillpolygon", "fillroundrect", "fillellipse",
+    "drawimage"
+};
+
+#define CANVAS_W 120
+#define CANVAS_H 70
+#define CANVAS_STRIDE 125
+
+static uint8_t ref[LCDWIDTH*LCDHEIGHT/8];
+static uint8_t cbuf[CANVAS_STRIDE*((CANVAS_H+7)/8)], cref[sizeof(cbuf)];
+static pcd8544_canvas_t rc = {ref, LCDWIDTH, LCDHEIGHT, LCDWIDTH}; /* where the reference draws */
+
+static void rset(int x, int y, int color)
+{
+    if((x<0)||(y<0)||(x>=rc.width)||(y>=rc.height)) return;
+    if(color) rc.buffer[x+(y/8)*rc.stride] |= 1<<(y%8);
+    else rc.buffer[x+(y/8)*rc.stride] &= ~(1<<(y%8));
+}
+
+static int rget(const pcd8544_canvas_t *s, int x, int y)
+{
+    return (s->buffer[x+(y/8)*s->stride]>>(y%8))&1;
+}
+
+static void rline(int x0, int y0, int x1, int y1, int color)
+{
+    int steep = ((y1>y0)?y1-y0:y0-y1)>((x1>x0)?x1-x0:x0-x1), t, dx, dy, err, ystep;
+    if(steep)
+    {
+        t = x0; x0 = y0; y0 = t;
+        t = x1; x1 = y1; y1 = t;
+    }
+    if(x0>x1)
+    {
+        t = x0; x0 = x1; x1 = t;
+        t = y0; y0 = y1; y1 = t;
+    }
+    dx = x1-x0;
+    dy = (y1>y0)?y1-y0:y0-y1;
+    err = dx/2;
+    ystep = (y0<y1)?1:-1;
+    for(; x0<=x1; ++x0)
+    {
+        if(steep) rset(y0, x0, color);
+        else rset(x0, y0, color);
+        err -= dy;
+        if(err<0)
+        {
+            y0 += ystep;
+            err += dx;
+        }
+    }
+}
+
+static void rfill(int x, int y, int w, int h, int color)
+{
+    int i, j;
+    for(i=x; i<x+w; ++i)
+    {
+        for(j=y; j<y+h; ++j) rset(i, j, color);
+    }
+}
+
+static void rcircle(int x0, int y0, int r, int color, int filled)
+{
+    int f = 1-r, ddF_x = 1, ddF_y = -2*r, x = 0, y = r;
+    if(filled) rfill(x0, y0-r, 1, 2*r+1, color);
+    else
+    {
+        rset(x0, y0+r, color);
+        rset(x0, y0-r, color);
+        rset(x0+r, y0, color);
+        rset(x0-r, y0, color);
+    }
+    while(x<y)
+    {
+        if(f>=0)
+        {
+            --y;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        ++x;
+        ddF_x += 2;
+        f += ddF_x;
+        if(filled)
+        {
+            rfill(x0+x, y0-y, 1, 2*y+1, color);
+            rfill(x0-x, y0-y, 1, 2*y+1, color);
+            rfill(x0+y, y0-x, 1, 2*x+1, color);
+            rfill(x0-y, y0-x, 1, 2*x+1, color);
+        }
+        else
+        {
+            rset(x0+x, y0+y, color);
+            rset(x0-x, y0+y, color);
+            rset(x0+x, y0-y, color);
+            rset(x0-x, y0-y, color);
+            rset(x0+y, y0+x, color);
+            rset(x0-y, y0+x, color);
+            rset(x0+y, y0-x, color);
+            rset(x0-y, y0-x, color);
+        }
+    }
+}
+
+static void rblit(int x, int y, const pcd8544_canvas_t *s, int sx, int sy, int w, int h, int rop)
+{
+    int i, j, b, X, Y;
+    uint8_t *d, m;
+    for(j=0; j<h; ++j)
+    {
+        for(i=0; i<w; ++i)
+        {
+            X = x+i;
+            Y = y+j;
+            if((X<0)||(Y<0)||(X>=rc.width)||(Y>=rc.height)) continue;
+            if((sx+i<0)||(sy+j<0)||(sx+i>=s->width)||(sy+j>=s->height)) continue;
+            b = rget(s, sx+i, sy+j);
+            d = &rc.buffer[X+(Y/8)*rc.stride];
+            m = 1<<(Y%8);
+            switch(rop)
+            {
+            case LCD_ROP_COPY:
+                *d = b?(*d|m):(*d&~m);
+                break;
+            case LCD_ROP_OR:
+                if(b) *d |= m;
+                break;
+            case LCD_ROP_AND:
+                if(!b) *d &= ~m;
+                break;
+            case LCD_ROP_ANDNOT:
+                if(b) *d &= ~m;
+                break;
+            case LCD_ROP_XOR:
+                if(b) *d ^= m;
+                break;
+            case LCD_ROP_INVERT:
+                *d = b?(*d&~m):(*d|m);
+                break;
+            }
+        }
+    }
+}
+
+static void rchar(int x, int y, uint8_t c, int s, int color)
+{
+    int i, j, col, b;
+    if((y>=rc.height)||((x+6*s-1)>=rc.width)) return;
+    for(i=0; i<6*s; ++i)
+    {
+        col = i/s;
+        for(j=0; j<8*s; ++j)
+        {
+            b = (col<5)?(pcd8544_font5x8.bitmap[c*5+col]>>(j/s))&1:0;
+            rset(x+i, y+j, color?b:!b);
+        }
+    }
+}
+
+/* even-odd test of every pixel centre against the polygon, in floating point */
+static void rpolygon(const int16_t *xy, int n, int color)
+{
+    int x, y, i, j, in;
+    double cx, cy, xa, ya, xb, yb;
+    for(x=0; x<rc.width; ++x)
+    {
+        for(y=0; y<rc.height; ++y)
+        {
+            cx = x+0.5;
+            cy = y+0.5;
+            for(i=0, in=0; i<n; ++i)
+            {
+                j = (i+1)%n;
+                xa = xy[2*i];
+                ya = xy[2*i+1];
+                xb = xy[2*j];
+                yb = xy[2*j+1];
+                if(((xa<=cx)!=(xb<=cx))&&((ya+(cx-xa)*(yb-ya)/(xb-xa))<=cy)) in = !in;
+            }
+            if(in) rset(x, y, color);
+        }
+    }
+}
+
+/* a cross of rectangles with a filled circle in each corner */
+static void rroundrect(int x, int y, int w, int h, int r, int color)
+{
+    if(!w||!h) return;
+    if(2*r>=w) r = (w-1)/2;
+    if(2*r>=h) r = (h-1)/2;
+    rfill(x+r, y, w-2*r, h, color);
+    rfill(x, y+r, r, h-2*r, color);
+    rfill(x+w-r, y+r, r, h-2*r, color);
+    rcircle(x+r, y+r, r, color, 1);
+    rcircle(x+w-1-r, y+r, r, color, 1);
+    rcircle(x+r, y+h-1-r, r, color, 1);
+    rcircle(x+w-1-r, y+h-1-r, r, color, 1);
+}
+
+static void rellipse(int x0, int y0, int rx, int ry, int color)
+{
+    int dx, dy;
+    int64_t a2 = (int64_t)rx*rx, b2 = (int64_t)ry*ry;
+    for(dx=-rx; dx<=rx; ++dx)
+    {
+        for(dy=-ry; dy<=ry; ++dy)
+        {
+            if((dx*dx*b2+dy*dy*a2)<=(a2*b2)) rset(x0+dx, y0+dy, color);
+        }
+    }
+}
+
+static void rbitmap(int x, int y, const uint8_t *bm, int w, int h, int rop)
+{
+    pcd8544_canvas_t s = {(uint8_t*)bm, w, h, w};
+    rblit(x, y, &s, 0, 0, w, h, rop);
+}
+
+/* box-scaled, dithered image of w x h at (x, y), each pixel computed on its own */
+static void rimage(int x, int y, int w, int h, const uint8_t *src, int sw, int sh, int format, int method)
+{
+    static int16_t err[256][LCDWIDTH+4];
+    static const uint8_t bayer[8][8] =
+    {
+        {0, 32, 8, 40, 2, 34, 10, 42}, {48, 16, 56, 24, 50, 18, 58, 26},
+        {12, 44, 4, 36, 14, 46, 6, 38}, {60, 28, 52, 20, 62, 30, 54, 22},
+        {3, 35, 11, 43, 1, 33, 9, 41}, {51, 19, 59, 27, 49, 17, 57, 25},
+        {15, 47, 7, 39, 13, 45, 5, 37}, {63, 31, 55, 23, 61, 29, 53, 21}
+    };
+    int i, j, u, v, x0, x1, y0, y1, g, e, black, bpp = format?3:1;
+    uint32_t sum;
+    memset(err, 0, sizeof(err));
+    for(j=0; j<h; ++j)
+    {
+        y0 = j*sh/h;
+        y1 = ((j+1)*sh/h>y0)?(j+1)*sh/h:y0+1;
+        for(i=0; i<w; ++i)
+        {
+            x0 = i*sw/w;
+            x1 = ((i+1)*sw/w>x0)?(i+1)*sw/w:x0+1;
+            for(sum=0, v=y0; v<y1; ++v)
+            {
+                for(u=x0; u<x1; ++u)
+                {
+                    const uint8_t *q = src+(v*sw+u)*bpp;
+                    sum += format?((77*q[0]+150*q[1]+29*q[2]+128)>>8):q[0];
+                }
+            }
+            g = (sum+(x1-x0)*(y1-y0)/2)/((x1-x0)*(y1-y0));
+            if(method<2) black = g<(method?(bayer[(y+j)&7][(x+i)&7]*4+2):128);
+            else
+            {
+                g += err[j][i+2];
+                black = g<128;
+                e = black?g:g-255;
+                if(method==2)
+                {
+                    err[j][i+3] += e*7/16;
+                    err[j+1][i+1] += e*3/16;
+                    err[j+1][i+2] += e*5/16;
+                    err[j+1][i+3] += e/16;
+                }
+                else
+                {
+                    err[j][i+3] += e/8;
+                    err[j][i+4] += e/8;
+                    err[j+1][i+1] += e/8;
+                    err[j+1][i+2] += e/8;
+                    err[j+1][i+3] += e/8;
+                    err[j+2][i+2] += e/8;
+                }
+            }
+            rset(x+i, y+j, black);
+        }
+    }
+}
+
+/* one random primitive on an off-screen canvas larger than the screen, with a padded stride */
+static void __canvascase(uint32_t k, int x, int y, int a, int b, int c)
+{
+    pcd8544_canvas_t cv;
+    uint8_t bm[40*5];
+    int16_t xy[12];
+    uint32_t i;
+    LCDcanvasInit(&cv, cbuf, CANVAS_W, CANVAS_H, CANVAS_STRIDE);
+    for(i=0; i<sizeof(cbuf); ++i) cbuf[i] = cref[i] = bench_rnd(k, 2000+i);
+    rc.buffer = cref;
+    rc.width = CANVAS_W;
+    rc.height = CANVAS_H;
+    rc.stride = CANVAS_STRIDE;
+    x -= 40;
+    y -= 40;
+    switch(bench_rnd(k, 7)%8)
+    {
+    case 0:
+        LCDcanvasDrawline(&cv, x, y, a-40, b-40, c);
+        rline(x, y, a-40, b-40, c);
+        break;
+    case 1:
+        LCDcanvasFillrect(&cv, x, y, a, b, c);
+        rfill(x, y, a, b, c);
+        break;
+    case 2:
+        LCDcanvasDrawcircle(&cv, x, y, a%64, c);
+        rcircle(x, y, a%64, c, 0);
+        break;
+    case 3:
+        LCDcanvasFillcircle(&cv, x, y, a%64, c);
+        rcircle(x, y, a%64, c, 1);
+        break;
+    case 4:
+        for(i=0; i<sizeof(bm); ++i) bm[i] = bench_rnd(k, 10+i);
+        LCDcanvasBlitbitmap(&cv, x, y, bm, 1+a%40, 1+b%40, c+bench_rnd(k, 6)%3*2);
+        rbitmap(x, y, bm, 1+a%40, 1+b%40, c+bench_rnd(k, 6)%3*2);
+        break;
+    case 5:
+        LCDcanvasDrawchar(&cv, x, y, (char)b, NULL, 1+a%4, c);
+        rchar(x, y, (uint8_t)b, 1+a%4, c);
+        break;
+    case 6:
+        for(i=0; i<12; ++i) xy[i] = (int)(bench_rnd(k, 20+i)%200)-40;
+        LCDcanvasFillpolygon(&cv, xy, 3+a%4, c);
+        rpolygon(xy, 3+a%4, c);
+        break;
+    case 7:
+        LCDcanvasFillroundrect(&cv, x, y, a, b, bench_rnd(k, 8)%40, c);
+        rroundrect(x, y, a, b, bench_rnd(k, 8)%40, c);
+        break;
+    }
+    rc.buffer = ref;
+    rc.width = rc.stride = LCDWIDTH;
+    rc.height = LCDHEIGHT;
+}
+
+static const char *__case(pcd8544_t *lcd, uint32_t k, char *params, uint8_t *canvas_ok)
+{
+    static uint8_t image[160*120*3];
+    uint8_t bm[40*5], frame[LCDWIDTH*LCDHEIGHT/8], src[100*9];
+    int16_t xy[32];
+    pcd8544_canvas_t cv;
+    uint32_t op = bench_rnd(k, 0)%OPS, i, sw, sh;
+    int x = bench_rnd(k, 1)%256, y = bench_rnd(k, 2)%256, a = bench_rnd(k, 3)%256, b = bench_rnd(k, 4)%256;
+    int c = bench_rnd(k, 5)&1, s;
+    *canvas_ok = 1;
+    switch(op)
+    {
+    case 0:
+        pcd8544_setPixel(lcd, x, y, c);
+        rset(x, y, c);
+        break;
+    case 1:
+        pcd8544_drawhline(lcd, x, y, a, c);
+        rfill(x, y, a, 1, c);
+        break;
+    case 2:
+        pcd8544_drawvline(lcd, x, y, a, c);
+        rfill(x, y, 1, a, c);
+        break;
+    case 3:
+        pcd8544_drawline(lcd, x, y, a, b, c);
+        rline(x, y, a, b, c);
+        break;
+    case 4:
+        pcd8544_drawrect(lcd, x, y, a, b, c);
+        if(a&&b)
+        {
+            rfill(x, y, a, 1, c);
+            rfill(x, y+b-1, a, 1, c);
+            rfill(x, y, 1, b, c);
+            rfill(x+a-1, y, 1, b, c);
+        }
+        break;
+    case 5:
+        pcd8544_fillrect(lcd, x, y, a, b, c);
+        rfill(x, y, a, b, c);
+        break;
+    case 6:
+    case 7:
+        a %= 128;
+        if(op==6) pcd8544_drawcircle(lcd, x, y, a, c);
+        else pcd8544_fillcircle(lcd, x, y, a, c);
+        rcircle(x, y, a, c, op==7);
+        break;
+    case 8:
+    case 9:
+        a = 1+a%40;
+        b = 1+b%40;
+        for(i=0; i<sizeof(bm); ++i) bm[i] = bench_rnd(k, 10+i);
+        if(op==8)
+        {
+            pcd8544_drawbitmap(lcd, x, y, bm, a, b, c);
+            rbitmap(x, y, bm, a, b, c?LCD_ROP_OR:LCD_ROP_ANDNOT);
+        }
+        else
+        {
+            x -= 128;
+            y -= 128;
+            c = bench_rnd(k, 6)%6;
+            pcd8544_blitbitmap(lcd, x, y, bm, a, b, c);
+            rbitmap(x, y, bm, a, b, c);
+        }
+        break;
+    case 10:
+        s = 1+a%4;
+        x %= LCDWIDTH;
+        y %= LCDHEIGHT+8;
+        pcd8544_setTextSize(lcd, s);
+        pcd8544_setTextColor(lcd, c);
+        pcd8544_drawchar(lcd, x, y, (char)b);
+        rchar(x, y, (uint8_t)b, s, c);
+        a = s;
+        break;
+    case 11:
+        for(i=0; i<sizeof(frame); ++i) frame[i] = bench_rnd(k, 10+i);
+        pcd8544_drawbitframe(lcd, frame, c?LCD_NEG:LCD_POS);
+        for(i=0; i<sizeof(frame); ++i) ref[i] = c?~frame[i]:frame[i];
+        break;
+    case 12:
+        for(i=0; i<sizeof(src); ++i) src[i] = bench_rnd(k, 10+i);
+        LCDcanvasInit(&cv, src, 1+bench_rnd(k, 8)%90, 1+bench_rnd(k, 9)%72, 0);
+        cv.stride += (sizeof(src)/((cv.height+7)/8)-cv.width)%5;
+        x -= 128;
+        y -= 128;
+        s = (int)(bench_rnd(k, 11)%128)-32;
+        c = bench_rnd(k, 6)%6;
+        pcd8544_blitcanvas(lcd, x, y, &cv, s, (int)(bench_rnd(k, 12)%96)-16, a%100, b%100, c);
+        rblit(x, y, &cv, s, (int)(bench_rnd(k, 12)%96)-16, a%100, b%100, c);
+        break;
+    case 13:
+        __canvascase(k, x, y, a, b, c);
+        *canvas_ok = !memcmp(cbuf, cref, sizeof(cbuf));
+        break;
+    case 14:
+    case 15:
+        s = (op==14)?3:3+a%14;
+        for(i=0; i<2*(uint32_t)s; ++i) xy[i] = (int)(bench_rnd(k, 20+i)%((i&1)?LCDHEIGHT+40:LCDWIDTH+40))-20;
+        if(op==14) pcd8544_filltriangle(lcd, xy[0], xy[1], xy[2], xy[3], xy[4], xy[5], c);
+        else pcd8544_fillpolygon(lcd, xy, s, c);
+        rpolygon(xy, s, c);
+        a = s;
+        break;
+    case 16:
+        s = bench_rnd(k, 8)%32;
+        pcd8544_fillroundrect(lcd, x, y, a, b, s, c);
+        rroundrect(x, y, a, b, s, c);
+        break;
+    case 17:
+        a %= 64;
+        b %= 64;
+        pcd8544_fillellipse(lcd, x, y, a, b, c);
+        rellipse(x, y, a, b, c);
+        break;
+    case 18:
+        x = x%(LCDWIDTH+40)-20;
+        y = y%(LCDHEIGHT+40)-20;
+        a = 1+a%LCDWIDTH;
+        b = 1+b%(LCDHEIGHT+16);
+        s = bench_rnd(k, 6)%16;
+        sw = (s&8)?(uint32_t)a:1+bench_rnd(k, 7)%160;
+        sh = (s&8)?(uint32_t)b:1+bench_rnd(k, 8)%120;
+        /* noise or a noisy ramp */
+        for(i=0; i<sw*sh*((s&4)?3:1); ++i) image[i] = (bench_rnd(k, 9)&1)?bench_rnd(k, 10+i):(i*7/((s&4)?3:1)+bench_rnd(k, 10+i)%32);
+        pcd8544_drawimage(lcd, x, y, a, b, image, sw, sh, 0, (s&4)?LCD_DITHER_RGB:LCD_DITHER_GRAY, s&3);
+        rimage(x, y, a, b, image, sw, sh, (s&4)?1:0, s&3);
+        c = s;
+        break;
+    }
+    sprintf(params, "%d, %d, %d, %d, %d", x, y, a, b, c);
+    return op_names[op];
+}
+
+/* a mock whose flush can be held shut, to park the thread sending a transfer */
+static pcd8544_mock_t gate_mock;
+static sem_t gate_open, gate_entered;
+static volatile int gate_closed;
+
+static void gate_flush(void *ctx)
+{
+    if(gate_closed)
+    {
+        sem_post(&gate_entered);
+        while(sem_wait(&gate_open)!=0);
+    }
+    ((pcd8544_mock_t*)ctx)->flushes++;
+}
+
+static pcd8544_t *__mocklcd(pcd8544_transport_t *t, pcd8544_mock_t *m)
+{
+    pcd8544_t *lcd = pcd8544_create();
+    if(lcd==NULL) return NULL;
+    LCDmockTransport(t, m);
+    pcd8544_inittransport(lcd, t, LCD_CONTRAST);
+    pcd8544_zero(lcd);
+    pcd8544_display(lcd);
+    return lcd;
+}
+
+typedef struct
+{
+    pcd8544_queue_t *q;
+    pcd8544_t *lcd; /* draws directly when q is NULL */
+    uint8_t id;
+    uint32_t posted; /* calls made, refused ones included */
+} producer_t;
+
+/* posts a command, retrying while the ring is full */
+#define QPOST(p, qcall, dcall) \
+    do \
+    { \
+        if((p)->q==NULL) dcall; \
+        else \
+        { \
+            ++(p)->posted; \
+            while(qcall<0) \
+            { \
+                ++(p)->posted; \
+                sched_yield(); \
+            } \
+        } \
+    } while(0)
+
+/* overlapping draws inside columns id*20..id*20+19, so the result depends on their order */
+static void *__producer(void *arg)
+{
+    producer_t *p = (producer_t*)arg;
+    pcd8544_queue_t *q = p->q;
+    pcd8544_t *lcd = p->lcd;
+    uint8_t x = p->id*20, i, c;
+    for(i=0; i<60; ++i)
+    {
+        c = i&1;
+        QPOST(p, LCDqueueFillrect(q, x+i%10, (i*7)%40, 10, 8, c), pcd8544_fillrect(lcd, x+i%10, (i*7)%40, 10, 8, c));
+        QPOST(p, LCDqueueDrawline(q, x, i%LCDHEIGHT, x+19, (i*13)%LCDHEIGHT, !c), pcd8544_drawline(lcd, x, i%LCDHEIGHT, x+19, (i*13)%LCDHEIGHT, !c));
+        QPOST(p, LCDqueueSetPixel(q, x+i%20, (i*5)%LCDHEIGHT, c), pcd8544_setPixel(lcd, x+i%20, (i*5)%LCDHEIGHT, c));
+        QPOST(p, LCDqueueDrawcircle(q, x+10, 24, i%10, c), pcd8544_drawcircle(lcd, x+10, 24, i%10, c));
+        QPOST(p, LCDqueueDrawvline(q, x+(i*3)%20, i%8, 30, !c), pcd8544_drawvline(lcd, x+(i*3)%20, i%8, 30, !c));
+        if(!(i%10)) QPOST(p, LCDqueueUpdate(q), pcd8544_update(lcd));
+    }
+    return NULL;
+}
+
+#define QUEUE_PRODUCERS 4
+
+static int __checkqueue(void)
+{
+    pcd8544_transport_t t, tr;
+    pcd8544_mock_t mr;
+    pcd8544_queuestats_t st;
+    pcd8544_queue_t *q;
+    producer_t p[QUEUE_PRODUCERS];
+    pthread_t th[QUEUE_PRODUCERS];
+    pcd8544_t *lcd = __mocklcd(&t, &gate_mock), *direct = __mocklcd(&tr, &mr);
+    uint32_t posted = 0, i;
+    int failed = 0;
+    if((lcd==NULL)||(direct==NULL)) return 1;
+    t.flush = gate_flush;
+    pcd8544_inittransport(lcd, &t, LCD_CONTRAST);
+    sem_init(&gate_open, 0, 0);
+    sem_init(&gate_entered, 0, 0);
+    /* concurrent producers on a small ring, then the same draws made directly */
+    q = pcd8544_queueCreate(lcd, 16);
+    if(q==NULL) return 1;
+    for(i=0; i<QUEUE_PRODUCERS; ++i)
+    {
+        p[i].q = q;
+        p[i].lcd = NULL;
+        p[i].id = i;
+        p[i].posted = 0;
+        pthread_create(th+i, NULL, __producer, p+i);
+    }
+    for(i=0; i<QUEUE_PRODUCERS; ++i)
+    {
+        pthread_join(th[i], NULL);
+        posted += p[i].posted;
+        p[i].q = NULL;
+        p[i].lcd = direct;
+        __producer(p+i);
+    }
+    while(LCDqueueUpdate(q)<0) ++posted;
+    ++posted;
+    LCDqueueSync(q);
+    LCDqueueGetStats(q, &st);
+    failed += !!memcmp(pcd8544_getbuffer(lcd), pcd8544_getbuffer(direct), LCDWIDTH*LCDHEIGHT/8);
+    failed += !!memcmp(gate_mock.ram, pcd8544_getbuffer(lcd), LCDWIDTH*LCDHEIGHT/8);
+    failed += (st.commands+st.dropped)!=posted;
+    failed += !st.updates||(st.batches>st.commands);
+    /* destroying the queue runs what is still in the ring */
+    for(i=0; i<8; ++i)
+    {
+        LCDqueueFillrect(q, i*10, i*5, 6, 6, BLACK);
+        pcd8544_fillrect(direct, i*10, i*5, 6, 6, BLACK);
+    }
+    LCDqueueDestroy(q);
+    failed += !!memcmp(pcd8544_getbuffer(lcd), pcd8544_getbuffer(direct), LCDWIDTH*LCDHEIGHT/8);
+    /* a ring of 2 behind a stalled transfer keeps 2 commands and refuses the rest */
+    pcd8544_zero(lcd);
+    q = pcd8544_queueCreate(lcd, 2);
+    if(q==NULL) return failed+1;
+    gate_closed = 1;
+    LCDqueueUpdate(q);
+    while(sem_wait(&gate_entered)!=0);
+    for(i=0, posted=0; i<10; ++i) posted += (LCDqueueSetPixel(q, i, 0, BLACK)==0);
+    LCDqueueGetStats(q, &st);
+    failed += (posted!=2)||(st.dropped!=8);
+    gate_closed = 0;
+    sem_post(&gate_open);
+    LCDqueueSync(q);
+    LCDqueueGetStats(q, &st);
+    failed += (st.commands!=3)||!pcd8544_getPixel(lcd, 1, 0)||pcd8544_getPixel(lcd, 2, 0);
+    LCDqueueDestroy(q);
+    sem_destroy(&gate_open);
+    sem_destroy(&gate_entered);
+    pcd8544_destroy(lcd);
+    pcd8544_destroy(direct);
+    return failed;
+}
+
+static uint64_t __nowms(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000+t.tv_nsec/1000000;
+}
+
+static int __checkasync(void)
+{
+    pcd8544_transport_t t;
+    pcd8544_t *lcd = __mocklcd(&t, &gate_mock);
+    uint32_t flushes, i;
+    uint64_t start;
+    int failed = 0;
+    if(lcd==NULL) return 1;
+    t.flush = gate_flush;
+    pcd8544_inittransport(lcd, &t, LCD_CONTRAST);
+    sem_init(&gate_open, 0, 0);
+    sem_init(&gate_entered, 0, 0);
+    pcd8544_setAsync(lcd, LCD_ON);
+    /* updates made while a transfer is held up are coalesced into one more */
+    flushes = gate_mock.flushes;
+    gate_closed = 1;
+    pcd8544_fillrect(lcd, 0, 0, 20, 20, BLACK);
+    pcd8544_update(lcd);
+    while(sem_wait(&gate_entered)!=0);
+    gate_closed = 0;
+    for(i=0; i<5; ++i)
+    {
+        pcd8544_fillcircle(lcd, 30+i*10, 24, 4+i, i&1);
+        pcd8544_drawline(lcd, 0, i*9, LCDWIDTH-1, 47-i*9, BLACK);
+        pcd8544_update(lcd);
+    }
+    sem_post(&gate_open);
+    pcd8544_waitFlush(lcd);
+    failed += !!memcmp(gate_mock.ram, pcd8544_getbuffer(lcd), LCDWIDTH*LCDHEIGHT/8);
+    failed += (gate_mock.flushes-flushes)!=2;
+    /* the frame cap delays frames, not a wait with nothing pending */
+    pcd8544_setFrameRateCap(lcd, 4);
+    pcd8544_fillrect(lcd, 40, 8, 20, 20, WHITE);
+    start = __nowms();
+    pcd8544_update(lcd);
+    pcd8544_waitFlush(lcd);
+    failed += (__nowms()-start)>100;
+    pcd8544_drawrect(lcd, 2, 2, 60, 40, BLACK);
+    pcd8544_update(lcd);
+    pcd8544_waitFlush(lcd);
+    failed += !!memcmp(gate_mock.ram, pcd8544_getbuffer(lcd), LCDWIDTH*LCDHEIGHT/8);
+    start = __nowms();
+    pcd8544_setAsync(lcd, LCD_OFF);
+    failed += (__nowms()-start)>100;
+    sem_destroy(&gate_open);
+    sem_destroy(&gate_entered);
+    pcd8544_destroy(lcd);
+    return failed;
+}
+
+#define DIFF_GAP 3 /* DIFF_MERGE_GAP in PCD8544.c */
+#define FRAME_RUN_CODE 0x40 /* FRAME_RUN in PCD8544.c */
+#define FRAME_LIT_CODE 0x80 /* FRAME_LIT in PCD8544.c */
+
+/* changed bytes and runs of them between the panel and the buffer */
+static uint32_t __diffruns(const uint8_t *ram, const uint8_t *buf, uint32_t *runs)
+{
+    uint32_t i, n = 0;
+    *runs = 0;
+    for(i=0; i<LCDWIDTH*LCDHEIGHT/8; ++i)
+    {
+        if(ram[i]==buf[i]) continue;
+        if(!i||(ram[i-1]==buf[i-1])) ++*runs;
+        ++n;
+    }
+    return n;
+}
+
+static int __checkdiff(void)
+{
+    pcd8544_transport_t t;
+    pcd8544_mock_t m;
+    pcd8544_t *lcd = __mocklcd(&t, &m);
+    uint8_t *buf;
+    uint32_t k, i, changed, runs;
+    int failed = 0;
+    if(lcd==NULL) return 1;
+    buf = pcd8544_getbuffer(lcd);
+    pcd8544_setDiffMode(lcd, LCD_ON);
+    for(i=0; i<LCDWIDTH*LCDHEIGHT/8; ++i) buf[i] = bench_rnd(i, 3000);
+    pcd8544_display(lcd);
+    for(k=0; k<400; ++k)
+    {
+        /* a few scattered bytes, whole transfers on even frames and dirty spans on odd ones */
+        for(i=0; i<1+k%12; ++i)
+        {
+            if(k&1) pcd8544_setPixel(lcd, (k*7+bench_rnd(k, 3100+i)%24)%LCDWIDTH, bench_rnd(k, 3200+i)%LCDHEIGHT, bench_rnd(k, 3300+i)&1);
+            else buf[(k*37+bench_rnd(k, 3100+i)%40)%(LCDWIDTH*LCDHEIGHT/8)] ^= 1<<(bench_rnd(k, 3200+i)&7);
+        }
+        changed = __diffruns(m.ram, buf, &runs);
+        LCDmockClear(&m);
+        if(k&1) pcd8544_update(lcd);
+        else pcd8544_display(lcd);
+        failed += !!memcmp(m.ram, buf, LCDWIDTH*LCDHEIGHT/8);
+        failed += m.data_bytes>(changed+DIFF_GAP*runs);
+        failed += m.command_bytes>(2*runs+2);
+    }
+    /* a gap of 2 is resent instead of readdressed, a gap of 6 is readdressed */
+    buf[100] ^= 1;
+    buf[103] ^= 1;
+    LCDmockClear(&m);
+    pcd8544_display(lcd);
+    failed += (m.data_bytes!=4)||(m.command_bytes!=4);
+    buf[200] ^= 1;
+    buf[207] ^= 1;
+    LCDmockClear(&m);
+    pcd8544_display(lcd);
+    failed += (m.data_bytes!=2)||(m.command_bytes!=6);
+    failed += !!memcmp(m.ram, buf, LCDWIDTH*LCDHEIGHT/8);
+    pcd8544_destroy(lcd);
+    return failed;
+}
+
+/* frame k of a mix of noise, sparse, striped and mostly blank content */
+static void __testframe(uint8_t *f, uint32_t k)
+{
+    uint32_t i;
+    for(i=0; i<LCDWIDTH*LCDHEIGHT/8; ++i)
+    {
+        switch(k%4)
+        {
+        case 0:
+            f[i] = bench_rnd(k, 4000+i);
+            break;
+        case 1:
+            f[i] = (bench_rnd(k, 4000+i)%16)?0x00:bench_rnd(k, 5000+i);
+            break;
+        case 2:
+            f[i] = ((i/(1+k%7))&1)?0xFF:(uint8_t)(i>>4);
+            break;
+        default:
+            f[i] = ((i>(k*11)%400)&&(i<(k*11)%400+60))?0x3C:0x00;
+            break;
+        }
+    }
+}
+
+static int __checkframes(void)
+{
+    pcd8544_transport_t t;
+    pcd8544_mock_t m;
+    pcd8544_rle_t d;
+    pcd8544_t *lcd = __mocklcd(&t, &m);
+    uint8_t frame[LCDWIDTH*LCDHEIGHT/8], prev[sizeof(frame)], out[2*LCD_FRAME_MAXSIZE], *buf;
+    uint32_t k, i, p, spans;
+    uint16_t n, used;
+    int first, last, r, failed = 0;
+    if(lcd==NULL) return 1;
+    buf = pcd8544_getbuffer(lcd);
+    __testframe(prev, 0);
+    for(k=1; k<300; ++k)
+    {
+        /* key frames decode to the frame over any buffer */
+        __testframe(frame, k);
+        n = LCDencodeFrame(frame, NULL, out, LCD_FRAME_MAXSIZE);
+        failed += (n==0)||(n>LCD_FRAME_MAXSIZE);
+        for(i=0; i<sizeof(frame); ++i) buf[i] = bench_rnd(k, 6000+i);
+        failed += (pcd8544_drawframe(lcd, out, n)!=0)||memcmp(buf, frame, sizeof(frame));
+        /* fed in random pieces, too */
+        LCDframeBegin(&d);
+        pcd8544_zero(lcd);
+        for(used=0; used<n; used+=r)
+        {
+            r = pcd8544_feedFrame(lcd, &d, out+used, 1+bench_rnd(k, 7000+used)%(n-used));
+            if(r<=0) break;
+        }
+        failed += (used!=n)||memcmp(buf, frame, sizeof(frame));
+        /* delta frames only touch the bytes that differ from prev */
+        n = LCDencodeFrame(frame, prev, out, LCD_FRAME_MAXSIZE);
+        failed += (n==0);
+        pcd8544_drawbitframe(lcd, prev, LCD_POS);
+        pcd8544_update(lcd);
+        LCDmockClear(&m);
+        failed += (pcd8544_drawframe(lcd, out, n)!=0)||memcmp(buf, frame, sizeof(frame));
+        pcd8544_update(lcd);
+        for(p=0, spans=0; p<LCDHEIGHT/8; ++p)
+        {
+            for(i=0, first=-1, last=-1; i<LCDWIDTH; ++i)
+            {
+                if(frame[p*LCDWIDTH+i]==prev[p*LCDWIDTH+i]) continue;
+                if(first<0) first = i;
+                last = i;
+            }
+            if(first>=0) spans += last-first+1;
+        }
+        failed += (m.data_bytes>spans)||memcmp(m.ram, buf, sizeof(frame));
+        memcpy(prev, frame, sizeof(frame));
+        /* truncated or overlong input is refused */
+        failed += (pcd8544_drawframe(lcd, out, bench_rnd(k, 8000)%n)!=-1);
+        out[n] = 0x00;
+        failed += (pcd8544_drawframe(lcd, out, n+1)!=-1);
+        /* so is an output buffer that is too small */
+        failed += (LCDencodeFrame(frame, NULL, out, LCDencodeFrame(frame, NULL, out, sizeof(out))-1)!=0);
+        /* and garbage never writes past the frame */
+        for(i=0; i<sizeof(out); ++i) out[i] = bench_rnd(k, 9000+i);
+        r = pcd8544_drawframe(lcd, out, 1+bench_rnd(k, 8001)%sizeof(out));
+        failed += (r!=0)&&(r!=-1);
+    }
+    /* operations crossing the end of the frame */
+    memset(out, 0x3F, 7);
+    out[7] = FRAME_LIT_CODE|127;
+    failed += (pcd8544_drawframe(lcd, out, 8+128)!=-1);
+    out[7] = FRAME_RUN_CODE|63;
+    out[8] = 0xAA;
+    failed += (pcd8544_drawframe(lcd, out, 9)!=-1);
+    pcd8544_destroy(lcd);
+    return failed;
+}
+
+#define PLAYER_FRAMES 12
+#define MS 1000000ULL
+
+static int __checkplayer(void)
+{
+    pcd8544_transport_t t;
+    pcd8544_mock_t m;
+    pcd8544_player_t p;
+    static uint8_t raw[PLAYER_FRAMES][LCDWIDTH*LCDHEIGHT/8];
+    const uint8_t *frames[PLAYER_FRAMES];
+    pcd8544_t *lcd = __mocklcd(&t, &m);
+    uint8_t *buf;
+    uint64_t start = 1000;
+    uint32_t i;
+    int r, failed = 0;
+    if(lcd==NULL) return 1;
+    buf = pcd8544_getbuffer(lcd);
+    for(i=0; i<PLAYER_FRAMES; ++i)
+    {
+        __testframe(raw[i], i);
+        frames[i] = raw[i];
+    }
+    memset(&p, 0xFF, sizeof(p));
+    LCDplayerInit(&p, frames, NULL, PLAYER_FRAMES, 100);
+    failed += (p.loop!=0);
+    LCDplayerMockClock(&p, &m);
+    m.now = start;
+    /* on time: frames go out exactly at start+k*10 ms */
+    pcd8544_playerStep(lcd, &p);
+    failed += (m.now!=start)||memcmp(buf, raw[0], sizeof(raw[0]));
+    pcd8544_playerStep(lcd, &p);
+    failed += (m.now!=start+10*MS)||(p.shown!=2)||memcmp(buf, raw[1], sizeof(raw[0]));
+    /* 45 ms in, frames 2 and 3 are drawn but dropped and frame 4 is sent 5 ms late */
+    m.now = start+45*MS;
+    pcd8544_playerStep(lcd, &p);
+    failed += (p.dropped!=2)||(p.shown!=3)||(p.late!=0)||(p.max_late_ns!=5*MS);
+    failed += memcmp(buf, raw[4], sizeof(raw[0]))||memcmp(m.ram, buf, sizeof(raw[0]));
+    /* the next deadline is still absolute */
+    pcd8544_playerStep(lcd, &p);
+    failed += (m.now!=start+50*MS)||(p.shown!=4);
+    /* a transfer slower than the interval makes a frame late */
+    m.byte_ns = 40000;
+    pcd8544_playerStep(lcd, &p);
+    failed += (p.late!=1);
+    m.byte_ns = 0;
+    while((r = pcd8544_playerStep(lcd, &p))==0);
+    failed += (r!=1)||((p.shown+p.dropped)!=PLAYER_FRAMES);
+    failed += memcmp(buf, raw[PLAYER_FRAMES-1], sizeof(raw[0]))||memcmp(m.ram, buf, sizeof(raw[0]));
+    failed += (pcd8544_playerStep(lcd, &p)!=1);
+    /* a looping player wraps around and never ends */
+    LCDplayerInit(&p, frames, NULL, 3, 50);
+    LCDplayerMockClock(&p, &m);
+    p.loop = 1;
+    for(i=0, r=0; i<7; ++i) r |= pcd8544_playerStep(lcd, &p);
+    failed += (r!=0)||(p.shown!=7)||(p.dropped!=0)||memcmp(buf, raw[0], sizeof(raw[0]));
+    pcd8544_destroy(lcd);
+    return failed;
+}
+
+/* a label, a bar drawn over its right end and two widgets clear of both */
+static void __widgets(pcd8544_scene_t *s, pcd8544_widget_t *w)
+{
+    uint8_t i;
+    LCDsceneInit(s);
+    LCDlabelInit(&w[0], 0, 0, 60, 8, &pcd8544_font5x8, 1);
+    LCDlabelSet(&w[0], "TEMP 21");
+    LCDbarInit(&w[1], 40, 0, 40, 8, 0, 100);
+    LCDbarSet(&w[1], 50);
+    LCDbarInit(&w[2], 0, 16, LCDWIDTH, 8, 0, 100);
+    LCDbarSet(&w[2], 30);
+    LCDsparklineInit(&w[3], 0, 32, 30, 16, 0, 100);
+    LCDsparklinePush(&w[3], 10);
+    LCDsparklinePush(&w[3], 90);
+    for(i=0; i<4; ++i) LCDsceneAdd(s, &w[i]);
+}
+
+/* sets the display RAM outside the page-aligned rect to the inverse of the buffer, so stray writes show */
+static void __poison(pcd8544_mock_t *m, const uint8_t *buf, uint8_t x, uint8_t p0, uint8_t w, uint8_t pages)
+{
+    uint32_t i;
+    for(i=0; i<LCDWIDTH*LCDHEIGHT/8; ++i)
+    {
+        if((i%LCDWIDTH>=x)&&(i%LCDWIDTH<x+w)&&(i/LCDWIDTH>=p0)&&(i/LCDWIDTH<p0+pages)) continue;
+        m->ram[i] = ~buf[i];
+    }
+}
+
+/* counts the bytes still poisoned outside the rect and the ones wrong inside it */
+static uint32_t __poisoned(const pcd8544_mock_t *m, const uint8_t *buf, uint8_t x, uint8_t p0, uint8_t w, uint8_t pages)
+{
+    uint32_t i, bad = 0;
+    for(i=0; i<LCDWIDTH*LCDHEIGHT/8; ++i)
+    {
+        if((i%LCDWIDTH>=x)&&(i%LCDWIDTH<x+w)&&(i/LCDWIDTH>=p0)&&(i/LCDWIDTH<p0+pages)) bad += (m->ram[i]!=buf[i]);
+        else bad += ((m->ram[i]^buf[i])!=0xFF);
+    }
+    return bad;
+}
+
+static int __checkwidgets(void)
+{
+    pcd8544_transport_t t, tr;
+    pcd8544_mock_t m, mr;
+    pcd8544_scene_t s, sr;
+    pcd8544_widget_t w[4], wr[4];
+    pcd8544_t *lcd = __mocklcd(&t, &m), *ref = __mocklcd(&tr, &mr);
+    uint8_t *buf;
+    uint32_t i;
+    int failed = 0;
+    if((lcd==NULL)||(ref==NULL)) return 1;
+    buf = pcd8544_getbuffer(lcd);
+    __widgets(&s, w);
+    failed += (pcd8544_sceneRender(lcd, &s)!=4);
+    pcd8544_update(lcd);
+    failed += !!memcmp(m.ram, buf, LCDWIDTH*LCDHEIGHT/8);
+    /* setters that leave the look unchanged mark nothing and send nothing */
+    LCDlabelSet(&w[0], "TEMP 21");
+    LCDbarSet(&w[1], 51);
+    LCDwidgetSetColor(&w[2], BLACK);
+    for(i=0; i<4; ++i) failed += (w[i].dirty!=0);
+    failed += (pcd8544_sceneRender(lcd, &s)!=0);
+    LCDmockClear(&m);
+    pcd8544_update(lcd);
+    failed += (m.data_bytes!=0);
+    /* a change to a widget clear of the others reaches only its own rect */
+    __poison(&m, buf, 0, 2, LCDWIDTH, 1);
+    LCDbarSet(&w[2], 80);
+    failed += (pcd8544_sceneRender(lcd, &s)!=1);
+    LCDmockClear(&m);
+    pcd8544_update(lcd);
+    failed += (__poisoned(&m, buf, 0, 2, LCDWIDTH, 1)!=0)||(m.data_bytes>LCDWIDTH);
+    /* redrawing the label repaints the bar on top of it, and nothing else */
+    memcpy(m.ram, buf, LCDWIDTH*LCDHEIGHT/8);
+    __poison(&m, buf, 0, 0, 80, 1);
+    LCDlabelSet(&w[0], "TEMP 22");
+    failed += (w[1].dirty!=0)||(pcd8544_sceneRender(lcd, &s)!=2);
+    pcd8544_update(lcd);
+    failed += (__poisoned(&m, buf, 0, 0, 80, 1)!=0);
+    /* the result matches the final state drawn from scratch */
+    __widgets(&sr, wr);
+    LCDbarSet(&wr[2], 80);
+    LCDlabelSet(&wr[0], "TEMP 22");
+    pcd8544_sceneRender(ref, &sr);
+    failed += !!memcmp(buf, pcd8544_getbuffer(ref), LCDWIDTH*LCDHEIGHT/8);
+    pcd8544_destroy(ref);
+    pcd8544_destroy(lcd);
+    return failed;
+}
+
+typedef struct
+{
+    const char *name;
+    int (*run)(void);
+} check_t;
+
+static const check_t checks[] =
+{
+    {"queue", __checkqueue},
+    {"async", __checkasync},
+    {"diff", __checkdiff},
+    {"frames", __checkframes},
+    {"player", __checkplayer},
+    {"widgets", __checkwidgets}
+};
+
+#define CHECKS (sizeof(checks)/sizeof(checks[0]))
+
+/** \brief Cross-checks every primitive against the reference rasterizers
+ *
+ * \param[in] cases uint32_t Number of random cases
+ * \return int Number of failures
+ *
+ */
+
+int bench_verify(uint32_t cases)
+{
+    pcd8544_transport_t t;
+    pcd8544_mock_t m;
+    pcd8544_t *lcd = pcd8544_create();
+    uint8_t *buf, bg[LCDWIDTH*LCDHEIGHT/8];
+    uint32_t k, i, failures[OPS], total = 0;
+    char params[64];
+    const char *name;
+    uint8_t canvas_ok;
+    if(lcd==NULL) return 1;
+    buf = pcd8544_getbuffer(lcd);
+    LCDmockTransport(&t, &m);
+    pcd8544_inittransport(lcd, &t, LCD_CONTRAST);
+    memset(failures, 0, sizeof(failures));
+    printf("{\n  \"verify\": {\n    \"cases\": %u,\n    \"mismatches\": [\n", cases);
+    for(k=0; k<cases; ++k)
+    {
+        if(!(k%16))
+        {
+            for(i=0; i<sizeof(bg); ++i) bg[i] = (k&16)?bench_rnd(k, 1000+i):0;
+            pcd8544_drawbitframe(lcd, bg, LCD_POS);
+            pcd8544_update(lcd);
+        }
+        memcpy(ref, buf, sizeof(ref));
+        name = __case(lcd, k, params, &canvas_ok);
+        pcd8544_update(lcd);
+        for(i=0; i<OPS; ++i)
+        {
+            if(op_names[i]==name) break;
+        }
+        if(!canvas_ok||memcmp(ref, buf, sizeof(ref))||memcmp(m.ram, buf, sizeof(ref)))
+        {
+            if(total<20) printf("%s      {\"case\": %u, \"op\": \"%s\", \"args\": [%s], \"wire\": %s}", total?",\n":"", k, name, params, memcmp(m.ram, buf, sizeof(ref))?"false":"true");
+            ++failures[i];
+            ++total;
+            memcpy(ref, buf, sizeof(ref));
+            pcd8544_display(lcd);
+        }
+    }
+    printf("%s    ],\n    \"failures\": {", total?"\n":"");
+    for(i=0; i<OPS; ++i) printf("%s\"%s\": %u", i?", ":"", op_names[i], failures[i]);
+    printf("},\n    \"checks\": {");
+    for(i=0; i<CHECKS; ++i)
+    {
+        k = checks[i].run();
+        total += k;
+        printf("%s\"%s\": %u", i?", ":"", checks[i].name, k);
+    }
+    printf("}\n  }\n}\n");
+    pcd8544_destroy(lcd);
+    return total;
+}
+
+/* fixed scenes for golden images; each starts from a clear buffer */
+static void __scene(pcd8544_t *lcd, uint8_t n)
+{
+    uint8_t i;
+    pcd8544_zero(lcd);
+    pcd8544_setTextSize(lcd, 1);
+    pcd8544_setTextColor(lcd, BLACK);
+    switch(n)
+    {
+    case 0:
+        pcd8544_drawstring(lcd, 0, 0, "Hello, world!");
+        pcd8544_setTextSize(lcd, 2);
+        pcd8544_drawstring(lcd, 0, 10, "12:34");
+        pcd8544_setTextSize(lcd, 1);
+        pcd8544_setTextColor(lcd, WHITE);
+        pcd8544_drawstring(lcd, 0, 30, "inverted");
+        break;
+    case 1:
+        for(i=0; i<LCDWIDTH; i+=7) pcd8544_drawline(lcd, i, 0, LCDWIDTH-1-i, LCDHEIGHT-1, BLACK);
+        pcd8544_drawline(lcd, 0, 24, 83, 24, BLACK);
+        break;
+    case 2:
+        pcd8544_drawcircle(lcd, 20, 24, 18, BLACK);
+        pcd8544_fillcircle(lcd, 60, 24, 14, BLACK);
+        pcd8544_fillcircle(lcd, 60, 24, 6, WHITE);
+        pcd8544_drawcircle(lcd, 80, 4, 10, BLACK);
+        break;
+    case 3:
+        pcd8544_drawrect(lcd, 2, 2, 40, 20, BLACK);
+        pcd8544_fillrect(lcd, 30, 10, 40, 30, BLACK);
+        pcd8544_fillrect(lcd, 40, 20, 10, 5, WHITE);
+        pcd8544_drawhline(lcd, 0, 46, 84, BLACK);
+        pcd8544_drawvline(lcd, 80, 0, 48, BLACK);
+        break;
+    case 4:
+        pcd8544_showLogo(lcd);
+        break;
+    }
+}
+
+#define SCENES 5
+
+/** \brief Writes the golden scenes as PBM images, or compares against them
+ *
+ * \param[in] dir char* Directory holding scene0.pbm, scene1.pbm, ...
+ * \param[in] write int Write the images instead of comparing (0/1)
+ * \return int Number of scenes that differ or could not be read/written
+ *
+ */
+
+int bench_golden(const char *dir, int write)
+{
+    pcd8544_transport_t t;
+    pcd8544_mock_t m;
+    pcd8544_t *lcd = pcd8544_create();
+    char path[512];
+    uint8_t n;
+    int r, failed = 0;
+    if(lcd==NULL) return 1;
+    LCDmockTransport(&t, &m);
+    pcd8544_inittransport(lcd, &t, LCD_CONTRAST);
+    printf("{\n  \"golden\": [\n");
+    for(n=0; n<SCENES; ++n)
+    {
+        __scene(lcd, n);
+        snprintf(path, sizeof(path), "%s/scene%u.pbm", dir, n);
+        r = write?pcd8544_savePBM(lcd, path):pcd8544_comparePBM(lcd, path);
+        if(r!=0) ++failed;
+        printf("    {\"scene\": \"%s\", \"%s\": %d}%s\n", path, write?"status":"differing_pixels", r, ((n+1)<SCENES)?",":"");
+    }
+    printf("  ]\n}\n");
+    pcd8544_destroy(lcd);
+    return failed;
+}
@@ -22,6 +22,9 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
+#ifndef PCD8544_H
+#define PCD8544_H
+
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -32,8 +35,16 @@ extern "C"
 #define BLACK 1
 #define WHITE 0
 
+/* panel geometry, override both (library and application alike) for compatible controllers, e.g. 102x64 */
+#ifndef LCDWIDTH
 #define LCDWIDTH 84
+#endif
+#ifndef LCDHEIGHT
 #define LCDHEIGHT 48
+#endif
+#if (LCDHEIGHT%8)||(LCDWIDTH>128)||(LCDHEIGHT>64)
+#error "The panel must fit in 128x64 with LCDHEIGHT a multiple of 8"
+#endif
 
 #define PCD8544_POWERDOWN 0x04
 #define PCD8544_ENTRYMODE 0x02
@@ -63,6 +74,13 @@ extern "C"
 #define LCD_OFF 0
 #define LCD_ON 1
 
+#define LCD_ROP_COPY 0
+#define LCD_ROP_OR 1
+#define LCD_ROP_ANDNOT 2
+#define LCD_ROP_XOR 3
+#define LCD_ROP_INVERT 4
+#define LCD_ROP_AND 5
+
 #define CLKCONST 400
 
 #define LSBFIRST 0
@@ -70,11 +88,338 @@ extern "C"
 
 extern uint8_t pcd8544_buffer[LCDWIDTH*LCDHEIGHT/8];
 
+/** \brief Transport backend through which every byte reaches the controller */
+typedef struct pcd8544_transport
+{
+    void (*command)(void *ctx, const uint8_t *c, uint16_t n); /**< Writes command bytes */
+    void (*data)(void *ctx, const uint8_t *c, uint16_t n); /**< Writes data bytes (c stays valid until the next setdc or flush, so it may be sent in place) */
+    void (*setdc)(void *ctx, uint8_t level); /**< Drives the Data/Command line (0 - command, 1 - data) */
+    void (*flush)(void *ctx); /**< Completes all pending transfers */
+    void (*reset)(void *ctx); /**< Pulses the reset line (optional, may be NULL) */
+    void (*close)(void *ctx); /**< Releases ctx when the display lets go of it (optional, may be NULL) */
+    void *ctx; /**< Backend private state */
+} pcd8544_transport_t;
+
+/** \brief Recording in-memory backend state */
+typedef struct pcd8544_mock
+{
+    uint32_t command_bytes; /**< Number of command bytes written */
+    uint32_t data_bytes; /**< Number of data bytes written */
+    uint32_t dc_toggles; /**< Number of Data/Command line changes */
+    uint32_t transactions; /**< Number of command/data write calls */
+    uint32_t flushes; /**< Number of flushes */
+    uint32_t resets; /**< Number of resets */
+    uint8_t dc; /**< Current Data/Command level */
+    uint8_t extended; /**< Extended instruction set selected */
+    uint8_t x; /**< Emulated X address */
+    uint8_t y; /**< Emulated Y address */
+    uint8_t ram[LCDWIDTH*LCDHEIGHT/8]; /**< Emulated display RAM */
+    uint32_t byte_ns; /**< Virtual time taken per byte written (see LCDplayerMockClock) */
+    uint64_t now; /**< Virtual time in ns */
+} pcd8544_mock_t;
+
+/** \brief Font descriptor
+ *
+ * Glyphs are stored back to back in the display's page-packed layout:
+ * a glyph of width w occupies w*((height+7)/8) bytes, byte i+(j/8)*w
+ * holding rows j..j+7 of column i. Fixed-width fonts may leave widths
+ * and offsets NULL; proportional fonts provide both.
+ */
+typedef struct pcd8544_font
+{
+    uint8_t first; /**< First character code */
+    uint8_t last; /**< Last character code */
+    uint8_t height; /**< Glyph height in pixels (also the line height) */
+    uint8_t spacing; /**< Blank columns after each glyph */
+    uint8_t width; /**< Glyph width for fixed-width fonts */
+    const uint8_t *widths; /**< Per-glyph widths (NULL - fixed width) */
+    const uint16_t *offsets; /**< Per-glyph byte offsets into bitmap (NULL - fixed width) */
+    const uint8_t *bitmap; /**< Glyph data */
+} pcd8544_font_t;
+
+extern const pcd8544_font_t pcd8544_font5x8;
+
+#define LCD_FRAME_MAXSIZE (LCDWIDTH*LCDHEIGHT/8+(LCDWIDTH*LCDHEIGHT/8+127)/128) /**< Worst-case compressed frame size */
+
+/** \brief Compressed frame decoder state */
+typedef struct pcd8544_rle
+{
+    uint16_t pos; /**< Bytes of the frame decoded so far */
+    uint8_t op; /**< Current operation */
+    uint8_t left; /**< Bytes left in the current operation */
+} pcd8544_rle_t;
+
+/** \brief Animation player state (see LCDplayerInit) */
+typedef struct pcd8544_player
+{
+    const uint8_t *const *frames; /**< Frames, raw or compressed */
+    const uint16_t *sizes; /**< Compressed frame sizes (NULL - raw frames) */
+    uint16_t count; /**< Number of frames */
+    uint8_t loop; /**< Restart after the last frame (0/1) */
+    uint32_t interval_ns; /**< Time between frame deadlines */
+    uint64_t (*now)(void *ctx); /**< Reads the clock in ns */
+    void (*sleepuntil)(void *ctx, uint64_t t); /**< Sleeps until the clock reaches t */
+    void *clock_ctx; /**< Clock private state */
+    uint8_t started; /**< The first deadline has been fixed */
+    uint16_t index; /**< Next frame to draw */
+    uint32_t frame; /**< Deadline number of the next frame */
+    uint64_t start; /**< Clock at the first deadline */
+    uint32_t shown; /**< Frames sent to the display */
+    uint32_t dropped; /**< Frames drawn but superseded before they could be sent */
+    uint32_t late; /**< Frames whose transfer ended after the next deadline */
+    uint64_t max_late_ns; /**< Worst delay between a deadline and its transfer */
+} pcd8544_player_t;
+
+#define LCD_STATS_BUCKETS 32 /**< Latency histogram buckets */
+
+/** \brief Display counters (see pcd8544_getStats, kept only when built with PCD8544_STATS) */
+typedef struct pcd8544_stats
+{
+    uint64_t setpixel_calls; /**< Single pixels plotted (setPixel, lines, circle outlines) */
+    uint32_t updates; /**< LCDupdate calls */
+    uint32_t displays; /**< LCDdisplay and LCDclear calls */
+    uint64_t command_bytes; /**< Command bytes handed to the transport */
+    uint64_t data_bytes; /**< Data bytes handed to the transport */
+    uint64_t dirty_bytes; /**< Buffer bytes (columns of 8-row pages) to be sent, summed over transfers */
+    uint32_t transfers; /**< Buffer transfers (an update or display each, sync or async) */
+    uint32_t last_bytes; /**< Bytes sent by the latest transfer */
+    uint32_t max_bytes; /**< Bytes sent by the largest transfer */
+    uint64_t transfer_ns; /**< Time spent in transfers, flushes included */
+    uint64_t max_transfer_ns; /**< Longest transfer */
+    uint32_t transfer_hist[LCD_STATS_BUCKETS]; /**< Transfers taking [2^i, 2^(i+1)) ns in bucket i (the last one is open-ended) */
+    uint64_t init_ns; /**< Time taken by the latest initialization, reset delays included */
+} pcd8544_stats_t;
+
+/** \brief Off-screen drawing surface in the display's page-packed layout (see LCDcanvasInit) */
+typedef struct pcd8544_canvas
+{
+    uint8_t *buffer; /**< Byte x+(y/8)*stride holds rows y&~7..y|7 of column x, LSB on top */
+    uint16_t width; /**< Width in pixels */
+    uint16_t height; /**< Height in pixels */
+    uint16_t stride; /**< Bytes from one 8-row page to the next (at least width) */
+} pcd8544_canvas_t;
+
+#define LCD_CANVAS_SIZE(w, h) ((w)*(((h)+7)/8)) /**< Buffer size of a canvas with stride w */
+
+#define LCD_WIDGET_LABEL 0
+#define LCD_WIDGET_BAR 1
+#define LCD_WIDGET_ICON 2
+#define LCD_WIDGET_SPARKLINE 3
+
+#define LCD_LABEL_MAX 21 /**< Longest label text */
+
+/** \brief Retained widget, a node of a pcd8544_scene_t (see LCDlabelInit, LCDbarInit, LCDiconInit, LCDsparklineInit) */
+typedef struct pcd8544_widget
+{
+    uint8_t type; /**< LCD_WIDGET_LABEL/LCD_WIDGET_BAR/LCD_WIDGET_ICON/LCD_WIDGET_SPARKLINE */
+    int16_t x; /**< Horizontal position of the rect */
+    int16_t y; /**< Vertical position of the rect */
+    uint8_t w; /**< Width of the rect (at most LCDWIDTH) */
+    uint8_t h; /**< Height of the rect (at most LCDHEIGHT) */
+    uint8_t color; /**< Foreground, the rect is cleared to the other colour (WHITE/BLACK) */
+    uint8_t dirty; /**< Needs to be rendered */
+    struct pcd8544_widget *next; /**< Next node in drawing order */
+    union
+    {
+        struct
+        {
+            char text[LCD_LABEL_MAX+1]; /**< Text */
+            const pcd8544_font_t *font; /**< Font */
+            uint8_t size; /**< Text size */
+        } label; /**< LCD_WIDGET_LABEL */
+        struct
+        {
+            int32_t value, min, max; /**< Value and range */
+            uint8_t fill; /**< Filled width in pixels */
+        } bar; /**< LCD_WIDGET_BAR */
+        struct
+        {
+            const uint8_t *bitmap; /**< Page-packed bitmap of w x h */
+        } icon; /**< LCD_WIDGET_ICON */
+        struct
+        {
+            int32_t min, max; /**< Range */
+            uint8_t rows[LCDWIDTH]; /**< Rows of the samples, oldest first */
+            uint8_t count; /**< Number of samples (at most w) */
+        } spark; /**< LCD_WIDGET_SPARKLINE */
+    } u; /**< Type-specific state */
+} pcd8544_widget_t;
+
+/** \brief Retained scene of widgets (see LCDsceneInit) */
+typedef struct pcd8544_scene
+{
+    pcd8544_widget_t *first; /**< First node, drawn first */
+    pcd8544_widget_t *last; /**< Last node, drawn on top */
+} pcd8544_scene_t;
+
+#define LCD_DITHER_GRAY 0 /**< One byte per source pixel */
+#define LCD_DITHER_RGB 1 /**< R, G, B bytes per source pixel */
+
+#define LCD_DITHER_THRESHOLD 0 /**< Black below mid-gray */
+#define LCD_DITHER_BAYER 1 /**< 8x8 ordered dither */
+#define LCD_DITHER_FLOYD 2 /**< Floyd-Steinberg error diffusion */
+#define LCD_DITHER_ATKINSON 3 /**< Atkinson error diffusion (diffuses 3/4 of the error, keeps more contrast) */
+
+/** \brief Streaming image import state (see LCDditherBegin) */
+typedef struct pcd8544_dither
+{
+    pcd8544_canvas_t canvas; /**< Destination canvas */
+    int16_t x; /**< Horizontal position of the rect */
+    int16_t y; /**< Vertical position of the rect */
+    uint8_t w; /**< Width of the rect (at most LCDWIDTH) */
+    uint8_t h; /**< Height of the rect */
+    uint16_t srcw; /**< Source width */
+    uint16_t srch; /**< Source height */
+    uint8_t format; /**< LCD_DITHER_GRAY/LCD_DITHER_RGB */
+    uint8_t method; /**< LCD_DITHER_THRESHOLD/LCD_DITHER_BAYER/LCD_DITHER_FLOYD/LCD_DITHER_ATKINSON */
+    uint16_t row; /**< Source rows fed so far */
+    uint8_t line; /**< Destination rows written so far */
+    uint8_t cur; /**< Error row of the current destination row */
+    uint16_t xstart[LCDWIDTH]; /**< First source column of each destination column */
+    uint16_t xend[LCDWIDTH]; /**< Source column past the last one of each destination column */
+    uint32_t sum[LCDWIDTH]; /**< Source pixels gathered for the current destination row */
+    int16_t err[3][LCDWIDTH+4]; /**< Diffused errors of the current and next two rows */
+} pcd8544_dither_t;
+
+#define LCD_QUEUE_TEXT 15 /**< Longest string carried by a queued command */
+
+/** \brief Draw command queue feeding a render thread (opaque, see pcd8544_queueCreate) */
+typedef struct pcd8544_queue pcd8544_queue_t;
+
+/** \brief Draw command queue counters (see LCDqueueGetStats) */
+typedef struct pcd8544_queuestats
+{
+    uint32_t commands; /**< Commands executed by the render thread */
+    uint32_t batches; /**< Times the render thread woke up and drained the ring */
+    uint32_t updates; /**< Transfers, one per batch holding update or display requests */
+    uint32_t dropped; /**< Commands refused because the ring was full */
+} pcd8544_queuestats_t;
+
+/** \brief Display instance (opaque) */
+typedef struct pcd8544 pcd8544_t;
+
+pcd8544_t *pcd8544_default();
+pcd8544_t *pcd8544_create();
+void pcd8544_destroy(pcd8544_t *lcd);
+uint8_t *pcd8544_getbuffer(pcd8544_t *lcd);
+void pcd8544_init(pcd8544_t *lcd, uint8_t SCLK, uint8_t DIN, uint8_t DC, uint8_t CS, uint8_t RST, uint8_t contrast, uint8_t spi_enabled);
+void pcd8544_inittransport(pcd8544_t *lcd, const pcd8544_transport_t *t, uint8_t contrast);
+void pcd8544_setPower(pcd8544_t *lcd, uint8_t mode);
+void pcd8544_showLogo(pcd8544_t *lcd);
+void pcd8544_drawbitmap(pcd8544_t *lcd, uint8_t x, uint8_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t color);
+void pcd8544_blitbitmap(pcd8544_t *lcd, int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t rop);
+void pcd8544_drawbitframe(pcd8544_t *lcd, const uint8_t *bitframe, uint8_t type);
+int pcd8544_feedFrame(pcd8544_t *lcd, pcd8544_rle_t *d, const uint8_t *data, uint16_t n);
+int pcd8544_drawframe(pcd8544_t *lcd, const uint8_t *data, uint16_t n);
+int pcd8544_playerStep(pcd8544_t *lcd, pcd8544_player_t *p);
+int pcd8544_play(pcd8544_t *lcd, pcd8544_player_t *p);
+int pcd8544_sceneRender(pcd8544_t *lcd, pcd8544_scene_t *s);
+pcd8544_queue_t *pcd8544_queueCreate(pcd8544_t *lcd, uint16_t capacity);
+int pcd8544_drawimage(pcd8544_t *lcd, int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *src, uint16_t srcw, uint16_t srch, uint32_t srcstride, uint8_t format, uint8_t method);
+void pcd8544_drawstring(pcd8544_t *lcd, uint8_t x, uint8_t y, char *c);
+void pcd8544_drawchar(pcd8544_t *lcd, uint8_t x, uint8_t y, char c);
+void pcd8544_write(pcd8544_t *lcd, uint8_t c);
+void pcd8544_setDisplayMode(pcd8544_t *lcd, uint8_t mode);
+void pcd8544_setContrast(pcd8544_t *lcd, uint8_t val);
+void pcd8544_setCursor(pcd8544_t *lcd, uint8_t x, uint8_t y);
+void pcd8544_setPosition(pcd8544_t *lcd, uint8_t x, uint8_t y);
+void pcd8544_setTextSize(pcd8544_t *lcd, uint8_t s);
+void pcd8544_setFont(pcd8544_t *lcd, const pcd8544_font_t *f);
+uint16_t pcd8544_stringWidth(pcd8544_t *lcd, const char *c);
+uint16_t pcd8544_stringHeight(pcd8544_t *lcd, const char *c);
+void pcd8544_setTextColor(pcd8544_t *lcd, uint8_t c);
+void pcd8544_setPixel(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t color);
+uint8_t pcd8544_getPixel(pcd8544_t *lcd, uint8_t x, uint8_t y);
+int pcd8544_savePBM(pcd8544_t *lcd, const char *path);
+int pcd8544_comparePBM(pcd8544_t *lcd, const char *path);
+int pcd8544_getStats(pcd8544_t *lcd, pcd8544_stats_t *s);
+void pcd8544_resetStats(pcd8544_t *lcd);
+void pcd8544_drawline(pcd8544_t *lcd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color);
+void pcd8544_drawrect(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color);
+void pcd8544_fillrect(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color);
+void pcd8544_drawhline(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t w, uint8_t color);
+void pcd8544_drawvline(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t h, uint8_t color);
+void pcd8544_drawcircle(pcd8544_t *lcd, uint8_t x0, uint8_t y0, uint8_t r, uint8_t color);
+void pcd8544_fillcircle(pcd8544_t *lcd, uint8_t x0, uint8_t y0, uint8_t r, uint8_t color);
+void pcd8544_filltriangle(pcd8544_t *lcd, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color);
+void pcd8544_fillpolygon(pcd8544_t *lcd, const int16_t *xy, uint8_t n, uint8_t color);
+void pcd8544_fillroundrect(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t r, uint8_t color);
+void pcd8544_fillellipse(pcd8544_t *lcd, uint8_t x0, uint8_t y0, uint8_t rx, uint8_t ry, uint8_t color);
+void pcd8544_getcanvas(pcd8544_t *lcd, pcd8544_canvas_t *c);
+void pcd8544_invalidate(pcd8544_t *lcd, int16_t x, int16_t y, uint16_t w, uint16_t h);
+void pcd8544_blitcanvas(pcd8544_t *lcd, int16_t x, int16_t y, const pcd8544_canvas_t *src, int16_t sx, int16_t sy, uint16_t w, uint16_t h, uint8_t rop);
+void pcd8544_spiwrite(pcd8544_t *lcd, uint8_t c);
+void pcd8544_spiwriteArray(pcd8544_t *lcd, uint8_t *c, uint16_t n);
+void pcd8544_command(pcd8544_t *lcd, uint8_t c);
+void pcd8544_commandArray(pcd8544_t *lcd, uint8_t *c, uint16_t n);
+void pcd8544_data(pcd8544_t *lcd, uint8_t c);
+void pcd8544_dataArray(pcd8544_t *lcd, uint8_t *c, uint16_t n);
+void pcd8544_setDiffMode(pcd8544_t *lcd, uint8_t mode);
+void pcd8544_setAsync(pcd8544_t *lcd, uint8_t mode);
+void pcd8544_waitFlush(pcd8544_t *lcd);
+void pcd8544_setFrameRateCap(pcd8544_t *lcd, uint16_t fps);
+void pcd8544_zero(pcd8544_t *lcd);
+void pcd8544_display(pcd8544_t *lcd);
+void pcd8544_update(pcd8544_t *lcd);
+void pcd8544_clear(pcd8544_t *lcd);
+
 void LCDInit(uint8_t SCLK, uint8_t DIN, uint8_t DC, uint8_t CS, uint8_t RST, uint8_t contrast, uint8_t spi_enabled);
+void LCDInitTransport(const pcd8544_transport_t *t, uint8_t contrast);
+int LCDspiTransport(pcd8544_transport_t *t, uint8_t DC, uint8_t RST);
+int LCDspiTransportChannel(pcd8544_transport_t *t, uint8_t channel, uint8_t DC, uint8_t RST);
+int LCDspidevTransport(pcd8544_transport_t *t, const char *spidev, const char *gpiochip, uint8_t DC, uint8_t RST, uint32_t speed);
+int LCDbitbangTransport(pcd8544_transport_t *t, uint8_t SCLK, uint8_t DIN, uint8_t DC, uint8_t CS, uint8_t RST);
+int LCDgpiomemTransport(pcd8544_transport_t *t, const char *gpiomem, uint8_t SCLK, uint8_t DIN, uint8_t DC, uint8_t CS, uint8_t RST, uint32_t speed);
+uint32_t LCDbitbangRate(const pcd8544_transport_t *t);
+void LCDmockTransport(pcd8544_transport_t *t, pcd8544_mock_t *m);
+void LCDmockClear(pcd8544_mock_t *m);
 void LCDsetPower(uint8_t mode);
 void LCDshowLogo();
 void LCDdrawbitmap(uint8_t x, uint8_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t color);
+void LCDblitbitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t rop);
 void LCDdrawbitframe(const uint8_t *bitframe, uint8_t type);
+void LCDframeBegin(pcd8544_rle_t *d);
+int LCDfeedFrame(pcd8544_rle_t *d, const uint8_t *data, uint16_t n);
+int LCDdrawframe(const uint8_t *data, uint16_t n);
+uint16_t LCDencodeFrame(const uint8_t *frame, const uint8_t *prev, uint8_t *out, uint16_t size);
+void LCDplayerInit(pcd8544_player_t *p, const uint8_t *const *frames, const uint16_t *sizes, uint16_t count, uint16_t fps);
+void LCDplayerMockClock(pcd8544_player_t *p, pcd8544_mock_t *m);
+int LCDplayerStep(pcd8544_player_t *p);
+int LCDplay(pcd8544_player_t *p);
+void LCDsceneInit(pcd8544_scene_t *s);
+void LCDsceneAdd(pcd8544_scene_t *s, pcd8544_widget_t *w);
+void LCDsceneInvalidate(pcd8544_scene_t *s);
+int LCDsceneRender(pcd8544_scene_t *s);
+void LCDlabelInit(pcd8544_widget_t *w, int16_t x, int16_t y, uint8_t width, uint8_t height, const pcd8544_font_t *f, uint8_t size);
+void LCDlabelSet(pcd8544_widget_t *w, const char *text);
+void LCDlabelSetNumber(pcd8544_widget_t *w, int32_t value);
+void LCDbarInit(pcd8544_widget_t *w, int16_t x, int16_t y, uint8_t width, uint8_t height, int32_t min, int32_t max);
+void LCDbarSet(pcd8544_widget_t *w, int32_t value);
+void LCDiconInit(pcd8544_widget_t *w, int16_t x, int16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height);
+void LCDiconSet(pcd8544_widget_t *w, const uint8_t *bitmap);
+void LCDsparklineInit(pcd8544_widget_t *w, int16_t x, int16_t y, uint8_t width, uint8_t height, int32_t min, int32_t max);
+void LCDsparklinePush(pcd8544_widget_t *w, int32_t value);
+void LCDwidgetSetColor(pcd8544_widget_t *w, uint8_t color);
+pcd8544_queue_t *LCDqueueCreate(uint16_t capacity);
+void LCDqueueDestroy(pcd8544_queue_t *q);
+void LCDqueueSync(pcd8544_queue_t *q);
+void LCDqueueGetStats(pcd8544_queue_t *q, pcd8544_queuestats_t *s);
+int LCDqueueSetPixel(pcd8544_queue_t *q, uint8_t x, uint8_t y, uint8_t color);
+int LCDqueueDrawline(pcd8544_queue_t *q, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color);
+int LCDqueueDrawrect(pcd8544_queue_t *q, uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color);
+int LCDqueueFillrect(pcd8544_queue_t *q, uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color);
+int LCDqueueDrawhline(pcd8544_queue_t *q, uint8_t x, uint8_t y, uint8_t w, uint8_t color);
+int LCDqueueDrawvline(pcd8544_queue_t *q, uint8_t x, uint8_t y, uint8_t h, uint8_t color);
+int LCDqueueDrawcircle(pcd8544_queue_t *q, uint8_t x0, uint8_t y0, uint8_t r, uint8_t color);
+int LCDqueueFillcircle(pcd8544_queue_t *q, uint8_t x0, uint8_t y0, uint8_t r, uint8_t color);
+int LCDqueueBlitbitmap(pcd8544_queue_t *q, int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t rop);
+int LCDqueueDrawstring(pcd8544_queue_t *q, uint8_t x, uint8_t y, const char *str, const pcd8544_font_t *f, uint8_t s, uint8_t color);
+int LCDqueueZero(pcd8544_queue_t *q);
+int LCDqueueUpdate(pcd8544_queue_t *q);
+int LCDqueueDisplay(pcd8544_queue_t *q);
+int LCDditherBegin(pcd8544_dither_t *d, const pcd8544_canvas_t *c, int16_t x, int16_t y, uint8_t w, uint8_t h, uint16_t srcw, uint16_t srch, uint8_t format, uint8_t method);
+int LCDditherRow(pcd8544_dither_t *d, const uint8_t *row);
+int LCDdrawimage(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *src, uint16_t srcw, uint16_t srch, uint32_t srcstride, uint8_t format, uint8_t method);
 void LCDdrawstring(uint8_t x, uint8_t line, char *c);
 void LCDdrawchar(uint8_t x, uint8_t line, char c);
 void LCDwrite(uint8_t c);
@@ -84,19 +429,59 @@ void LCDsetCursor(uint8_t x, uint8_t y);
 void LCDsetPosition(uint8_t x, uint8_t y);
 void LCDsetTextSize(uint8_t s);
 void LCDsetTextColor(uint8_t c);
+void LCDsetFont(const pcd8544_font_t *f);
+uint16_t LCDstringWidth(const char *c);
+uint16_t LCDstringHeight(const char *c);
 void LCDsetPixel(uint8_t x, uint8_t y, uint8_t color);
 uint8_t LCDgetPixel(uint8_t x, uint8_t y);
+int LCDsavePBM(const char *path);
+int LCDcomparePBM(const char *path);
+int LCDgetStats(pcd8544_stats_t *s);
+void LCDresetStats();
 void LCDdrawline(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color);
 void LCDdrawrect(uint8_t x, uint8_t y, uint8_t w, uint8_t h,uint8_t color);
 void LCDfillrect(uint8_t x, uint8_t y, uint8_t w, uint8_t h,uint8_t color);
+void LCDdrawhline(uint8_t x, uint8_t y, uint8_t w, uint8_t color);
+void LCDdrawvline(uint8_t x, uint8_t y, uint8_t h, uint8_t color);
 void LCDdrawcircle(uint8_t x0, uint8_t y0, uint8_t r,uint8_t color);
 void LCDfillcircle(uint8_t x0, uint8_t y0, uint8_t r,uint8_t color);
+void LCDfilltriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color);
+void LCDfillpolygon(const int16_t *xy, uint8_t n, uint8_t color);
+void LCDfillroundrect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t r, uint8_t color);
+void LCDfillellipse(uint8_t x0, uint8_t y0, uint8_t rx, uint8_t ry, uint8_t color);
+void LCDgetcanvas(pcd8544_canvas_t *c);
+void LCDinvalidate(int16_t x, int16_t y, uint16_t w, uint16_t h);
+void LCDblitcanvas(int16_t x, int16_t y, const pcd8544_canvas_t *src, int16_t sx, int16_t sy, uint16_t w, uint16_t h, uint8_t rop);
+int LCDcanvasInit(pcd8544_canvas_t *c, uint8_t *buffer, uint16_t w, uint16_t h, uint16_t stride);
+void LCDcanvasFill(const pcd8544_canvas_t *c, uint8_t color);
+void LCDcanvasSetPixel(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint8_t color);
+uint8_t LCDcanvasGetPixel(const pcd8544_canvas_t *c, int16_t x, int16_t y);
+void LCDcanvasDrawline(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color);
+void LCDcanvasDrawrect(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t color);
+void LCDcanvasFillrect(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t color);
+void LCDcanvasDrawhline(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t w, uint8_t color);
+void LCDcanvasDrawvline(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t h, uint8_t color);
+void LCDcanvasDrawcircle(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, uint8_t r, uint8_t color);
+void LCDcanvasFillcircle(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, uint8_t r, uint8_t color);
+void LCDcanvasFilltriangle(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color);
+void LCDcanvasFillpolygon(const pcd8544_canvas_t *c, const int16_t *xy, uint8_t n, uint8_t color);
+void LCDcanvasFillroundrect(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t r, uint8_t color);
+void LCDcanvasFillellipse(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, uint8_t rx, uint8_t ry, uint8_t color);
+void LCDcanvasBlitbitmap(const pcd8544_canvas_t *c, int16_t x, int16_t y, const uint8_t *bitmap, uint16_t w, uint16_t h, uint8_t rop);
+void LCDcanvasBlit(const pcd8544_canvas_t *dst, int16_t x, int16_t y, const pcd8544_canvas_t *src, int16_t sx, int16_t sy, uint16_t w, uint16_t h, uint8_t rop);
+uint8_t LCDcanvasDrawchar(const pcd8544_canvas_t *c, int16_t x, int16_t y, char ch, const pcd8544_font_t *f, uint8_t s, uint8_t color);
+int LCDcanvasDrawimage(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *src, uint16_t srcw, uint16_t srch, uint32_t srcstride, uint8_t format, uint8_t method);
+void LCDcanvasDrawstring(const pcd8544_canvas_t *c, int16_t x, int16_t y, const char *str, const pcd8544_font_t *f, uint8_t s, uint8_t color);
 void LCDspiwrite(uint8_t c);
 void LCDspiwriteArray(uint8_t *c, uint16_t n);
 void LCDcommand(uint8_t c);
 void LCDcommandArray(uint8_t *c, uint16_t n);
 void LCDdata(uint8_t c);
 void LCDdataArray(uint8_t *c, uint16_t n);
+void LCDsetDiffMode(uint8_t mode);
+void LCDsetAsync(uint8_t mode);
+void LCDwaitFlush();
+void LCDsetFrameRateCap(uint16_t fps);
 void LCDzero();
 void LCDdisplay();
 void LCDupdate();
@@ -105,3 +490,5 @@ void delay(uint32_t msecs);
 #ifdef __cplusplus
 }
 #endif
+
+#endif // PCD8544_H
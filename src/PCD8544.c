@@ -23,25 +23,26 @@
 **/
 
 #include <inttypes.h>
-#include <wiringPi.h>
-#include <wiringPiSPI.h>
-#include <bitBang.h>
+#include <errno.h>
 #include <string.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <time.h>
+#include <pthread.h>
 #include "../include/PCD8544.h"
+#include "PCD8544_private.h"
 
 /** \cond HIDDEN_SYMBOLS */
-#define abs(a) (((a)<0)?-(a):(a))
-#define swap(a, b) {uint8_t t = a; a = b; b = t;}
+#define swap(a, b) {int16_t t = a; a = b; b = t;}
 #define _BV(bit) (0x1<<(bit))
 
-static uint8_t cursor_x, cursor_y, textsize, textcolor;
-static int8_t _din, _sclk, _dc, _rst, _cs, _spi_enabled;
+#define DC_COMMAND 0
+#define DC_DATA 1
 
 /** \endcond */
 
-static unsigned char font[] =
+static const unsigned char font[] =
 {
     0x00, 0x00, 0x00, 0x00, 0x00,
     0x3E, 0x5B, 0x4F, 0x5B, 0x3E,
@@ -298,10 +299,10 @@ static unsigned char font[] =
     0x00, 0x19, 0x1D, 0x17, 0x12,
     0x00, 0x3C, 0x3C, 0x3C, 0x3C,
     0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00,
 };
 
-uint8_t pcd8544_buffer[LCDWIDTH*LCDHEIGHT/8] = {0,}; /**< PCD8544 drawing buffer */
-uint8_t pcd8544_buffer2[LCDWIDTH*LCDHEIGHT/8] = {0,}; /**< PCD8544 second drawing buffer for SPI */
+const pcd8544_font_t pcd8544_font5x8 = {0x00, 0xFF, 8, 1, 5, NULL, NULL, font}; /**< Built-in 5x8 font */
 
 const uint8_t pi_logo [] =
 {
@@ -341,685 +342,2659 @@ const uint8_t pi_logo [] =
 
 /** \cond HIDDEN_SYMBOLS */
 
-static void __setpixel(uint8_t x, uint8_t y, uint8_t color)
+static void __setpixel(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint8_t color)
+{
+    if(((uint16_t)x>=c->width)||((uint16_t)y>=c->height)) return; /* negatives wrap above any width */
+    if(color) c->buffer[x+(y>>3)*c->stride] |= _BV(y&7);
+    else c->buffer[x+(y>>3)*c->stride] &= ~_BV(y&7);
+}
+
+/* applies a page mask to columns x0..x1 of page p, four bytes at a time */
+static void __maskcols(const pcd8544_canvas_t *c, uint16_t p, uint16_t x0, uint16_t x1, uint8_t mask, uint8_t color)
+{
+    uint8_t *row = c->buffer+p*c->stride+x0;
+    uint16_t n = x1-x0+1;
+    uint32_t m = mask*0x01010101UL, v;
+    if(color)
+    {
+        for(; n>=4; n-=4, row+=4)
+        {
+            memcpy(&v, row, 4);
+            v |= m;
+            memcpy(row, &v, 4);
+        }
+        for(; n; --n, ++row) *row |= mask;
+    }
+    else
+    {
+        for(; n>=4; n-=4, row+=4)
+        {
+            memcpy(&v, row, 4);
+            v &= ~m;
+            memcpy(row, &v, 4);
+        }
+        for(; n; --n, ++row) *row &= ~mask;
+    }
+}
+
+/* fills the block x0..x1, y0..y1 (inclusive, inside the canvas) */
+static void __fillblock(const pcd8544_canvas_t *c, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t color)
+{
+    uint16_t p, p0 = y0>>3, p1 = y1>>3;
+    uint8_t m0 = 0xFF<<(y0&7), m1 = 0xFF>>(7-(y1&7)), *col;
+    if(x0==x1) /* a single column, as the span fills produce */
+    {
+        col = c->buffer+p0*c->stride+x0;
+        if(p0==p1) m0 &= m1;
+        if(color)
+        {
+            *col |= m0;
+            for(p=p0+1; p<p1; ++p) *(col += c->stride) = 0xFF;
+            if(p0!=p1) *(col+c->stride) |= m1;
+        }
+        else
+        {
+            *col &= ~m0;
+            for(p=p0+1; p<p1; ++p) *(col += c->stride) = 0x00;
+            if(p0!=p1) *(col+c->stride) &= ~m1;
+        }
+        return;
+    }
+    if(p0==p1)
+    {
+        __maskcols(c, p0, x0, x1, m0&m1, color);
+        return;
+    }
+    __maskcols(c, p0, x0, x1, m0, color);
+    for(p=p0+1; p<p1; ++p) memset(c->buffer+p*c->stride+x0, color?0xFF:0x00, x1-x0+1);
+    __maskcols(c, p1, x0, x1, m1, color);
+}
+
+#define BLITLOOP(OP) \
+    for(i=i0; i<i1; ++i) \
+    { \
+        b = ssh?(uint8_t)((src[i]>>ssh)|(next?(next[i]<<(8-ssh)):0)):src[i]; \
+        v = ((uint16_t)b<<sh)&m; \
+        if(lo) { OP(lo[x+i], (uint8_t)v, (uint8_t)m); } \
+        if(hi) { OP(hi[x+i], (uint8_t)(v>>8), (uint8_t)(m>>8)); } \
+    }
+#define ROP_COPY(d, s, m) d = (d&~(m))|(s)
+#define ROP_OR(d, s, m) d |= (s)
+#define ROP_AND(d, s, m) d &= (s)|~(m)
+#define ROP_ANDNOT(d, s, m) d &= ~(s)
+#define ROP_XOR(d, s, m) d ^= (s)
+#define ROP_INVERT(d, s, m) d = (d&~(m))|((s)^(m))
+
+/* composites the w x h block at (sx, sy) of s (inside s) onto c at (x, y), a page column at a time, clipped to c */
+static void __blit(const pcd8544_canvas_t *c, int16_t x, int16_t y, const pcd8544_canvas_t *s, uint16_t sx, uint16_t sy, uint16_t w, uint16_t h, uint8_t rop)
+{
+    int32_t i, i0, i1, dy, dp;
+    uint16_t sp, sr, pages = (c->height+7)>>3, spages = (s->height+7)>>3;
+    uint8_t sh, ssh = sy&7, vm, b, tail = 0xFF>>((8-(c->height&7))&7); /* rows of the last page inside c */
+    uint16_t v, m;
+    const uint8_t *src, *next;
+    uint8_t *lo, *hi;
+    i0 = (x<0)?-x:0;
+    i1 = ((x+w)>c->width)?(c->width-x):w;
+    if(i0>=i1) return;
+    for(sp=0; (sp<<3)<h; ++sp)
+    {
+        vm = ((h-(sp<<3))>=8)?0xFF:(uint8_t)((1<<(h-(sp<<3)))-1);
+        dy = y+(sp<<3);
+        dp = (dy>=0)?(dy>>3):-((7-dy)>>3);
+        sh = dy-dp*8;
+        if((dp>=pages)||(dp<-1)) continue;
+        sr = (sy>>3)+sp;
+        src = s->buffer+sr*s->stride+sx;
+        next = (ssh&&((sr+1)<spages))?(src+s->stride):NULL;
+        m = (uint16_t)vm<<sh;
+        if((dp+1)==pages) m &= tail;
+        else if((dp+2)==pages) m &= 0xFF|((uint16_t)tail<<8);
+        lo = ((dp>=0)&&(m&0xFF))?(c->buffer+dp*c->stride):NULL;
+        hi = (((dp+1)<pages)&&(m>>8))?(c->buffer+(dp+1)*c->stride):NULL;
+        switch(rop)
+        {
+        case LCD_ROP_COPY:
+            BLITLOOP(ROP_COPY);
+            break;
+        case LCD_ROP_AND:
+            BLITLOOP(ROP_AND);
+            break;
+        case LCD_ROP_ANDNOT:
+            BLITLOOP(ROP_ANDNOT);
+            break;
+        case LCD_ROP_XOR:
+            BLITLOOP(ROP_XOR);
+            break;
+        case LCD_ROP_INVERT:
+            BLITLOOP(ROP_INVERT);
+            break;
+        default:
+            BLITLOOP(ROP_OR);
+            break;
+        }
+    }
+}
+
+/* blits a page-packed bitmap (stride w) */
+static void __blitbitmap(const pcd8544_canvas_t *c, int16_t x, int16_t y, const uint8_t *bitmap, uint16_t w, uint16_t h, uint8_t rop)
+{
+    pcd8544_canvas_t s;
+    s.buffer = (uint8_t*)bitmap;
+    s.width = s.stride = w;
+    s.height = h;
+    __blit(c, x, y, &s, 0, 0, w, h, rop);
+}
+
+/* clips x0..x1, y0..y1 (inclusive) to the canvas and fills it */
+static void __fillrect(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color)
+{
+    if(x0<0) x0 = 0;
+    if(y0<0) y0 = 0;
+    if(x1>(c->width-1)) x1 = c->width-1;
+    if(y1>(c->height-1)) y1 = c->height-1;
+    if((x0>x1)||(y0>y1)) return;
+    __fillblock(c, x0, y0, x1, y1, color);
+}
+
+/* the shape x0..x1, y0..y1 (inclusive) lies inside the canvas */
+static uint8_t __inside(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    return (x0>=0)&&(y0>=0)&&(x1<c->width)&&(y1<c->height);
+}
+
+/*
+ * Unclipped pixel writes with the colour fixed. Circles test their whole
+ * extent once and then run one of these loops, expanded per colour and,
+ * for canvases as wide as the panel (the screen included), with the stride
+ * a compile-time constant. Circles crossing the edge fall back to the
+ * clipping __setpixel.
+ */
+#define PLOT_BLACK(b, s, x, y) (b)[(x)+((y)>>3)*(s)] |= _BV((y)&7)
+#define PLOT_WHITE(b, s, x, y) (b)[(x)+((y)>>3)*(s)] &= ~_BV((y)&7)
+#define PLOT_CLIP(b, s, x, y) __setpixel(c, x, y, color)
+
+#define CIRCLELOOP(PLOT, S) \
+    PLOT(b, S, x0, y0+r); \
+    PLOT(b, S, x0, y0-r); \
+    PLOT(b, S, x0+r, y0); \
+    PLOT(b, S, x0-r, y0); \
+    while(x<y) \
+    { \
+        if(f>=0) \
+        { \
+            --y; \
+            ddF_y += 2; \
+            f += ddF_y; \
+        } \
+        ++x; \
+        ddF_x += 2; \
+        f += ddF_x; \
+        PLOT(b, S, x0+x, y0+y); \
+        PLOT(b, S, x0-x, y0+y); \
+        PLOT(b, S, x0+x, y0-y); \
+        PLOT(b, S, x0-x, y0-y); \
+        PLOT(b, S, x0+y, y0+x); \
+        PLOT(b, S, x0-y, y0+x); \
+        PLOT(b, S, x0+y, y0-x); \
+        PLOT(b, S, x0-y, y0-x); \
+    }
+
+/*
+ * Line stepping on the page-packed layout, from byte p and bit m. A shallow
+ * line moves one byte per point and changes bit on a minor step. A steep
+ * line walks down a column and gathers the points of each run into one
+ * byte write per page. A 45 degree line needs no error term.
+ */
+#define BITS_SET(p, m) *(p) |= (m)
+#define BITS_CLR(p, m) *(p) &= ~(m)
+
+#define SHALLOWLOOP(OP) \
+    for(; n; --n, ++p) \
+    { \
+        OP(p, m); \
+        err -= dy; \
+        if(err<0) \
+        { \
+            err += dx; \
+            if(ystep>0) \
+            { \
+                if(!(m = (uint8_t)(m<<1))) \
+                { \
+                    m = 0x01; \
+                    p += c->stride; \
+                } \
+            } \
+            else if(!(m >>= 1)) \
+            { \
+                m = 0x80; \
+                p -= c->stride; \
+            } \
+        } \
+    }
+
+#define DIAGONALLOOP(OP) \
+    for(; n; --n, ++p) \
+    { \
+        OP(p, m); \
+        if(ystep>0) \
+        { \
+            if(!(m = (uint8_t)(m<<1))) \
+            { \
+                m = 0x01; \
+                p += c->stride; \
+            } \
+        } \
+        else if(!(m >>= 1)) \
+        { \
+            m = 0x80; \
+            p -= c->stride; \
+        } \
+    }
+
+#define STEEPLOOP(OP) \
+    for(run=0; n; --n) \
+    { \
+        run |= m; \
+        m = (uint8_t)(m<<1); \
+        err -= dy; \
+        if(err<0) \
+        { \
+            err += dx; \
+            OP(p, run); \
+            run = 0; \
+            p += ystep; \
+        } \
+        if(!m) \
+        { \
+            if(run) OP(p, run); \
+            run = 0; \
+            m = 0x01; \
+            p += c->stride; \
+        } \
+    } \
+    if(run) OP(p, run);
+
+/* first and last steps of a shallow Bresenham walk whose minor coordinate
+ * y0+ystep*k stays in 0..lim-1, k = ceil((i*dy-dx/2)/dx) after i steps */
+static uint8_t __lineclip(int32_t y0, int32_t ystep, int32_t dx, int32_t dy, int32_t lim, int32_t *i0, int32_t *i1)
+{
+    int64_t kmin = (ystep>0)?-y0:(y0-lim+1), kmax = (ystep>0)?(lim-1-y0):y0, h = dx/2, i;
+    if((kmax<0)||(kmin>dy)) return 0;
+    if(kmin>0)
+    {
+        i = ((kmin-1)*dx+h)/dy+1;
+        if(i>*i0) *i0 = (int32_t)i;
+    }
+    if(kmax<dy)
+    {
+        i = (kmax*dx+h)/dy;
+        if(i<*i1) *i1 = (int32_t)i;
+    }
+    return *i0<=*i1;
+}
+
+/* outcode of a point against the canvas, as in Cohen-Sutherland */
+static uint8_t __outcode(const pcd8544_canvas_t *c, int32_t x, int32_t y)
+{
+    return (x<0)|((x>=c->width)<<1)|((y<0)<<2)|((y>=c->height)<<3);
+}
+
+/*
+ * Bresenham from (x0, y0) to (x1, y1), returns the number of points on the
+ * line. Horizontal and vertical lines are filled as spans. Others are
+ * rejected or accepted whole by their endpoint outcodes; a line crossing
+ * an edge starts and stops at the first and last steps inside, with the
+ * error term the full walk would have there, so clipping never moves a
+ * point.
+ */
+static uint16_t __line(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color)
+{
+    int32_t X0 = x0, Y0 = y0, X1 = x1, Y1 = y1, dx, dy, err, ystep, i0, i1, k, t, n;
+    uint8_t steep, code0 = __outcode(c, x0, y0), code1 = __outcode(c, x1, y1), m, run, *p;
+    if(Y0==Y1)
+    {
+        __fillrect(c, (X0<X1)?X0:X1, Y0, (X0<X1)?X1:X0, Y0, color);
+        return ((X0<X1)?(X1-X0):(X0-X1))+1;
+    }
+    if(X0==X1)
+    {
+        __fillrect(c, X0, (Y0<Y1)?Y0:Y1, X0, (Y0<Y1)?Y1:Y0, color);
+        return ((Y0<Y1)?(Y1-Y0):(Y0-Y1))+1;
+    }
+    steep = ((Y1>Y0)?(Y1-Y0):(Y0-Y1))>((X1>X0)?(X1-X0):(X0-X1));
+    if(steep)
+    {
+        t = X0; X0 = Y0; Y0 = t;
+        t = X1; X1 = Y1; Y1 = t;
+    }
+    if(X0>X1)
+    {
+        t = X0; X0 = X1; X1 = t;
+        t = Y0; Y0 = Y1; Y1 = t;
+    }
+    dx = X1-X0;
+    dy = (Y1>Y0)?(Y1-Y0):(Y0-Y1);
+    ystep = (Y0<Y1)?1:-1;
+    if(code0&code1) return dx+1;
+    i0 = 0;
+    i1 = dx;
+    if(code0|code1)
+    {
+        t = steep?c->height:c->width;
+        if(X0<0) i0 = -X0;
+        if(X1>=t) i1 = t-1-X0;
+        if((i0>i1)||!__lineclip(Y0, ystep, dx, dy, steep?c->width:c->height, &i0, &i1)) return dx+1;
+    }
+    k = ((int64_t)i0*dy-dx/2+dx-1)/dx;
+    err = dx/2-i0*dy+k*dx;
+    X0 += i0;
+    Y0 += ystep*k;
+    n = i1-i0+1;
+    if(steep)
+    {
+        p = c->buffer+Y0+(X0>>3)*c->stride;
+        m = _BV(X0&7);
+        if(color)
+        {
+            STEEPLOOP(BITS_SET);
+        }
+        else
+        {
+            STEEPLOOP(BITS_CLR);
+        }
+        return dx+1;
+    }
+    p = c->buffer+X0+(Y0>>3)*c->stride;
+    m = _BV(Y0&7);
+    switch(((dx==dy)<<1)|(color!=0))
+    {
+    case 0:
+        SHALLOWLOOP(BITS_CLR);
+        break;
+    case 1:
+        SHALLOWLOOP(BITS_SET);
+        break;
+    case 2:
+        DIAGONALLOOP(BITS_CLR);
+        break;
+    default:
+        DIAGONALLOOP(BITS_SET);
+        break;
+    }
+    return dx+1;
+}
+
+static void __rect(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t color)
+{
+    if(!w||!h) return;
+    if(__inside(c, x, y, x+w-1, y+h-1))
+    {
+        __fillblock(c, x, y, x+w-1, y, color);
+        __fillblock(c, x, y+h-1, x+w-1, y+h-1, color);
+        __fillblock(c, x, y, x, y+h-1, color);
+        __fillblock(c, x+w-1, y, x+w-1, y+h-1, color);
+        return;
+    }
+    __fillrect(c, x, y, x+w-1, y, color);
+    __fillrect(c, x, y+h-1, x+w-1, y+h-1, color);
+    __fillrect(c, x, y, x, y+h-1, color);
+    __fillrect(c, x+w-1, y, x+w-1, y+h-1, color);
+}
+
+/* midpoint circle outline, returns the number of points plotted */
+static uint16_t __circle(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, uint8_t r, uint8_t color)
+{
+    int16_t f = 1-r, ddF_x = 1, ddF_y = -2*r, x = 0, y = r;
+    uint8_t *b = c->buffer;
+    uint16_t s = c->stride;
+    switch(__inside(c, x0-r, y0-r, x0+r, y0+r)?(((s==LCDWIDTH)<<1)|(color!=0)):4)
+    {
+    case 0:
+        CIRCLELOOP(PLOT_WHITE, s);
+        break;
+    case 1:
+        CIRCLELOOP(PLOT_BLACK, s);
+        break;
+    case 2:
+        CIRCLELOOP(PLOT_WHITE, LCDWIDTH);
+        break;
+    case 3:
+        CIRCLELOOP(PLOT_BLACK, LCDWIDTH);
+        break;
+    default:
+        CIRCLELOOP(PLOT_CLIP, s);
+        break;
+    }
+    return 4+8*x;
+}
+
+/* half-height of each column of a midpoint circle of radius r, ext[0..r] */
+static void __circleext(uint8_t r, int16_t *ext)
+{
+    int16_t f = 1-r, ddF_x = 1, ddF_y = -2*r, x = 0, y = r, i;
+    ext[0] = r;
+    for(i=1; i<=r; ++i) ext[i] = -1;
+    while(x<y)
+    {
+        if(f>=0)
+        {
+            --y;
+            ddF_y += 2;
+            f += ddF_y;
+        }
+        ++x;
+        ddF_x += 2;
+        f += ddF_x;
+        if(y>ext[x]) ext[x] = y;
+        if(x>ext[y]) ext[y] = x;
+    }
+}
+
+#define CIRCLESPANS(FILL) \
+    FILL(c, x0, y0-r, x0, y0+r, color); \
+    for(i=1; i<=r; ++i) \
+    { \
+        if(ext[i]<0) continue; \
+        FILL(c, x0+i, y0-ext[i], x0+i, y0+ext[i], color); \
+        FILL(c, x0-i, y0-ext[i], x0-i, y0+ext[i], color); \
+    }
+
+/* filled circle as one vertical span per column, clipped only when it sticks out */
+static void __fillcircle(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, uint8_t r, uint8_t color)
+{
+    int16_t ext[256], i; /* half-height of each column offset */
+    __circleext(r, ext);
+    if(__inside(c, x0-r, y0-r, x0+r, y0+r))
+    {
+        CIRCLESPANS(__fillblock);
+    }
+    else
+    {
+        CIRCLESPANS(__fillrect);
+    }
+}
+
+/*
+ * Column-span fill engine. Each shape yields vertical spans column by
+ * column; runs of neighbouring columns with the same span are merged so
+ * they are written as one block of page-masked bytes.
+ */
+typedef struct
+{
+    const pcd8544_canvas_t *c;
+    int16_t x0, x1, y0, y1;
+    uint8_t color;
+} spanrun_t;
+
+static void __spanbegin(spanrun_t *r, const pcd8544_canvas_t *c, uint8_t color)
+{
+    r->c = c;
+    r->x0 = r->y0 = 0;
+    r->x1 = r->y1 = -1;
+    r->color = color;
+}
+
+static void __spanflush(spanrun_t *r)
+{
+    if(r->x0<=r->x1) __fillrect(r->c, r->x0, r->y0, r->x1, r->y1, r->color);
+    r->x1 = r->x0-1;
+}
+
+/* adds rows y0..y1 of columns x0..x1 */
+static void __spanadd(spanrun_t *r, int16_t x0, int16_t x1, int16_t y0, int16_t y1)
+{
+    if(y0>y1) return;
+    if((r->x0<=r->x1)&&(x0==(r->x1+1))&&(y0==r->y0)&&(y1==r->y1))
+    {
+        r->x1 = x1;
+        return;
+    }
+    __spanflush(r);
+    r->x0 = x0;
+    r->x1 = x1;
+    r->y0 = y0;
+    r->y1 = y1;
+}
+
+static int32_t __ceildiv(int64_t a, int64_t b)
+{
+    return (a>=0)?(int32_t)((a+b-1)/b):-(int32_t)((-a)/b);
+}
+
+/* a polygon edge stepped across columns x0..x1-1: q is the first row
+ * whose centre is on or below it, e the error term of that rounding */
+typedef struct
+{
+    int32_t x0, x1, q, e, a, b, d;
+} polyedge_t;
+
+/*
+ * Even-odd polygon fill. Vertices lie on pixel corners and a pixel is set
+ * when its centre is inside, so shapes sharing an edge never overlap and
+ * the rectangle (x, y)-(x+w, y+h) covers the same pixels as fillrect.
+ */
+static void __fillpolygon(const pcd8544_canvas_t *c, const int16_t *xy, uint8_t n, uint8_t color)
+{
+    polyedge_t edges[255], *pe;
+    int16_t rows[255];
+    int32_t xmin = 32767, xmax = -32768, x, xa, ya, xb, yb, t;
+    int64_t num;
+    uint8_t i, j, k, m, ne = 0;
+    spanrun_t r;
+    if(n<3) return;
+    for(i=0; i<n; ++i)
+    {
+        if(xy[2*i]<xmin) xmin = xy[2*i];
+        if(xy[2*i]>xmax) xmax = xy[2*i];
+    }
+    if(xmin<0) xmin = 0;
+    if(xmax>c->width) xmax = c->width;
+    for(i=0; i<n; ++i)
+    {
+        j = ((i+1)==n)?0:(i+1);
+        xa = xy[2*i];
+        ya = xy[2*i+1];
+        xb = xy[2*j];
+        yb = xy[2*j+1];
+        if(xa>xb)
+        {
+            t = xa; xa = xb; xb = t;
+            t = ya; ya = yb; yb = t;
+        }
+        if((xa==xb)||(xb<=xmin)||(xa>=xmax)) continue;
+        pe = edges+ne++;
+        pe->x0 = (xa<xmin)?xmin:xa;
+        pe->x1 = xb;
+        pe->d = 2*(xb-xa);
+        num = (int64_t)(2*(pe->x0-xa)+1)*(yb-ya)-(xb-xa);
+        t = __ceildiv(num, pe->d);
+        pe->q = ya+t;
+        pe->e = (int32_t)((int64_t)t*pe->d-num);
+        pe->a = __ceildiv(2*(yb-ya), pe->d);
+        pe->b = pe->a*pe->d-2*(yb-ya);
+    }
+    __spanbegin(&r, c, color);
+    for(x=xmin; x<xmax; ++x)
+    {
+        for(i=0, k=0, pe=edges; i<ne; ++i, ++pe)
+        {
+            if((x<pe->x0)||(x>=pe->x1)) continue;
+            for(m=k++; m&&(rows[m-1]>pe->q); --m) rows[m] = rows[m-1];
+            rows[m] = pe->q;
+            pe->q += pe->a;
+            pe->e += pe->b;
+            if(pe->e>=pe->d)
+            {
+                --pe->q;
+                pe->e -= pe->d;
+            }
+        }
+        for(i=0; (i+1)<k; i+=2) __spanadd(&r, x, x, rows[i], rows[i+1]-1);
+    }
+    __spanflush(&r);
+}
+
+/* rectangle with its corners rounded by midpoint circles of radius rad */
+static void __fillroundrect(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t rad, uint8_t color)
+{
+    int16_t ext[256], i;
+    spanrun_t r;
+    if(!w||!h) return;
+    if((2*rad)>=w) rad = (w-1)/2;
+    if((2*rad)>=h) rad = (h-1)/2;
+    __circleext(rad, ext);
+    __spanbegin(&r, c, color);
+    for(i=rad; i>0; --i)
+    {
+        if(ext[i]>=0) __spanadd(&r, x+rad-i, x+rad-i, y+rad-ext[i], y+h-1-rad+ext[i]);
+    }
+    __spanadd(&r, x+rad, x+w-1-rad, y, y+h-1);
+    for(i=1; i<=rad; ++i)
+    {
+        if(ext[i]>=0) __spanadd(&r, x+w-1-rad+i, x+w-1-rad+i, y+rad-ext[i], y+h-1-rad+ext[i]);
+    }
+    __spanflush(&r);
+}
+
+/* filled axis-aligned ellipse: the pixels with (dx/rx)^2+(dy/ry)^2 <= 1 */
+static void __fillellipse(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, uint8_t rx, uint8_t ry, uint8_t color)
+{
+    int16_t ext[256], dx, dy = ry;
+    int64_t a2 = (int64_t)rx*rx, b2 = (int64_t)ry*ry;
+    spanrun_t r;
+    for(dx=0; dx<=rx; ++dx)
+    {
+        while((dy>0)&&((dx*dx*b2+dy*dy*a2)>(a2*b2))) --dy;
+        ext[dx] = dy;
+    }
+    __spanbegin(&r, c, color);
+    for(dx=rx; dx>0; --dx) __spanadd(&r, x0-dx, x0-dx, y0-ext[dx], y0+ext[dx]);
+    for(dx=0; dx<=rx; ++dx) __spanadd(&r, x0+dx, x0+dx, y0-ext[dx], y0+ext[dx]);
+    __spanflush(&r);
+}
+
+/* clips a canvas-to-canvas blit to the source, returns 0 if nothing is left */
+static uint8_t __clipsource(const pcd8544_canvas_t *s, int16_t *x, int16_t *y, int16_t *sx, int16_t *sy, int32_t *w, int32_t *h)
+{
+    if(*sx<0)
+    {
+        *w += *sx;
+        *x -= *sx;
+        *sx = 0;
+    }
+    if(*sy<0)
+    {
+        *h += *sy;
+        *y -= *sy;
+        *sy = 0;
+    }
+    if((*sx+*w)>s->width) *w = s->width-*sx;
+    if((*sy+*h)>s->height) *h = s->height-*sy;
+    return (*w>0)&&(*h>0);
+}
+
+#define MAXTEXTSIZE 4
+
+static uint32_t glyph_cache[MAXTEXTSIZE-1][256][5]; /* expanded font columns */
+static pthread_once_t glyph_once = PTHREAD_ONCE_INIT;
+
+/* expands every font column for every text size, once for all displays */
+static void __buildglyphs(void)
+{
+    uint32_t expand_lut[256], v; /* byte -> bits repeated s times */
+    uint16_t i, c;
+    uint8_t s, b, r;
+    for(s=2; s<=MAXTEXTSIZE; ++s)
+    {
+        for(i=0; i<256; ++i)
+        {
+            for(v=0, b=0; b<8; ++b)
+            {
+                if(i&_BV(b))
+                {
+                    for(r=0; r<s; ++r) v |= 1UL<<(b*s+r);
+                }
+            }
+            expand_lut[i] = v;
+        }
+        for(c=0; c<256; ++c)
+        {
+            for(i=0; i<5; ++i) glyph_cache[s-2][c][i] = expand_lut[font[c*5+i]];
+        }
+    }
+}
+
+/* returns the five font columns of c expanded to the text size times the height */
+static const uint32_t *__scaledglyph(uint8_t c, uint8_t s)
+{
+    pthread_once(&glyph_once, __buildglyphs);
+    return glyph_cache[s-2][c];
+}
+
+/* returns the page-packed columns of c in f and its width, NULL if not in the font */
+static const uint8_t *__glyph(const pcd8544_font_t *f, uint8_t c, uint8_t *w)
+{
+    uint8_t k;
+    if((c<f->first)||(c>f->last)) return NULL;
+    k = c-f->first;
+    *w = f->widths?f->widths[k]:f->width;
+    return f->bitmap+(f->offsets?f->offsets[k]:k*f->width*((f->height+7)>>3));
+}
+
+/* horizontal advance of c in pixels at size s, 0 if not in the font */
+static uint8_t __advance(const pcd8544_font_t *f, uint8_t s, uint8_t c)
+{
+    uint8_t w;
+    if(f==&pcd8544_font5x8) return 6*s;
+    if(!__glyph(f, c, &w)) return 0;
+    return w+f->spacing;
+}
+
+static uint8_t __lineheight(const pcd8544_font_t *f, uint8_t s)
+{
+    if(f==&pcd8544_font5x8) return 8*s;
+    return f->height;
+}
+
+/* copies glyph columns straight into the canvas, returns 0 if off the canvas */
+static uint8_t __drawchar(const pcd8544_canvas_t *cv, int16_t x, int16_t y, uint8_t c, const pcd8544_font_t *f, uint8_t s, uint8_t color)
+{
+    uint8_t cols[6*MAXTEXTSIZE*MAXTEXTSIZE], i, r, p, w = 0, adv = __advance(f, s, c);
+    const uint8_t *g;
+    const uint32_t *sg;
+    if(y>=cv->height) return 0;
+    if(!adv||((x+adv-1)>=cv->width)) return 0;
+    if((f==&pcd8544_font5x8)&&(s>1))
+    {
+        sg = __scaledglyph(c, s);
+        for(p=0; p<s; ++p)
+        {
+            for(i=0; i<5; ++i)
+            {
+                for(r=0; r<s; ++r) cols[p*adv+i*s+r] = color?(uint8_t)(sg[i]>>(p*8)):(uint8_t)~(sg[i]>>(p*8));
+            }
+            memset(cols+p*adv+5*s, color?0x00:0xFF, s);
+        }
+        __blitbitmap(cv, x, y, cols, adv, 8*s, LCD_ROP_COPY);
+        return 1;
+    }
+    g = __glyph(f, c, &w);
+    __blitbitmap(cv, x, y, g, w, f->height, color?LCD_ROP_COPY:LCD_ROP_INVERT);
+    if(adv>w) __fillrect(cv, x+w, y, x+adv-1, y+f->height-1, !color);
+    return 1;
+}
+
+/* prints at the cursor and grows box (xmin, ymin, xmax, ymax) by what was drawn */
+static void __write(pcd8544_t *lcd, uint8_t c, int16_t *box)
+{
+    uint8_t adv, lh = __lineheight(lcd->textfont, lcd->textsize);
+    if(c=='\n')
+    {
+        lcd->cursor_y += lh;
+        if(lcd->cursor_y>=LCDHEIGHT) lcd->cursor_y = 0;
+        lcd->cursor_x = 0;
+    }
+    else if(c!='\r')
+    {
+        adv = __advance(lcd->textfont, lcd->textsize, c);
+        if(lcd->cursor_x&&((lcd->cursor_x+adv)>LCDWIDTH))
+        {
+            lcd->cursor_x = 0;
+            lcd->cursor_y += lh;
+            if(lcd->cursor_y>=LCDHEIGHT) lcd->cursor_y = 0;
+        }
+        if(__drawchar(&lcd->screen, lcd->cursor_x, lcd->cursor_y, c, lcd->textfont, lcd->textsize, lcd->textcolor))
+        {
+            if(lcd->cursor_x<box[0]) box[0] = lcd->cursor_x;
+            if(lcd->cursor_y<box[1]) box[1] = lcd->cursor_y;
+            if((lcd->cursor_x+adv-1)>box[2]) box[2] = lcd->cursor_x+adv-1;
+            if((lcd->cursor_y+lh-1)>box[3]) box[3] = lcd->cursor_y+lh-1;
+        }
+        lcd->cursor_x += adv;
+        if((lcd->cursor_x+adv)>LCDWIDTH)
+        {
+            lcd->cursor_x = 0;
+            lcd->cursor_y += lh;
+        }
+        if(lcd->cursor_y>=LCDHEIGHT) lcd->cursor_y = 0;
+    }
+}
+
+
+#define DIRTY_MERGE_GAP 4 /* clean bytes cheaper to resend than a new address */
+
+/* merges span j into span i and removes it, keeping spans sorted */
+static void __spanmerge(dirty_page_t *d, uint8_t i, uint8_t j)
+{
+    if(d->x0[j]<d->x0[i]) d->x0[i] = d->x0[j];
+    if(d->x1[j]>d->x1[i]) d->x1[i] = d->x1[j];
+    for(--d->n; j<d->n; ++j)
+    {
+        d->x0[j] = d->x0[j+1];
+        d->x1[j] = d->x1[j+1];
+    }
+}
+
+static uint8_t __spangap(const dirty_page_t *d, uint8_t i, uint8_t x0, uint8_t x1)
+{
+    if(x1<d->x0[i]) return d->x0[i]-x1-1;
+    if(x0>d->x1[i]) return x0-d->x1[i]-1;
+    return 0;
+}
+
+static void __markdirty(dirty_page_t *d, uint8_t x0, uint8_t x1)
+{
+    uint8_t i, best = 0, bestgap = 0xFF, gap;
+    for(i=0; i<d->n; ++i)
+    {
+        gap = __spangap(d, i, x0, x1);
+        if(gap<bestgap)
+        {
+            bestgap = gap;
+            best = i;
+        }
+    }
+    if((bestgap>DIRTY_MERGE_GAP)&&(d->n<DIRTY_SPANS))
+    {
+        for(i=d->n; (i>0)&&(d->x0[i-1]>x0); --i)
+        {
+            d->x0[i] = d->x0[i-1];
+            d->x1[i] = d->x1[i-1];
+        }
+        d->x0[i] = x0;
+        d->x1[i] = x1;
+        ++d->n;
+        return;
+    }
+    if(x0<d->x0[best]) d->x0[best] = x0;
+    if(x1>d->x1[best]) d->x1[best] = x1;
+    while(((best+1)<d->n)&&(__spangap(d, best, d->x0[best+1], d->x1[best+1])<=DIRTY_MERGE_GAP)) __spanmerge(d, best, best+1);
+    while((best>0)&&(__spangap(d, best, d->x0[best-1], d->x1[best-1])<=DIRTY_MERGE_GAP))
+    {
+        __spanmerge(d, best-1, best);
+        --best;
+    }
+}
+
+static void __cleardirty(dirty_page_t *d)
+{
+    uint8_t p;
+    for(p=0; p<LCDPAGES; ++p) d[p].n = 0;
+}
+
+static void updateBoundingBox(pcd8544_t *lcd, int16_t xmin, int16_t ymin, int16_t xmax, int16_t ymax)
+{
+    uint8_t p;
+    if(xmin<0) xmin = 0;
+    if(ymin<0) ymin = 0;
+    if(xmax>(LCDWIDTH-1)) xmax = LCDWIDTH-1;
+    if(ymax>(LCDHEIGHT-1)) ymax = LCDHEIGHT-1;
+    if((xmin>xmax)||(ymin>ymax)) return;
+    for(p=(ymin>>3); p<=(ymax>>3); ++p) __markdirty(&lcd->dirty[p], xmin, xmax);
+}
+
+static void __setdc(pcd8544_t *lcd, uint8_t level)
+{
+    if(level==lcd->dc) return;
+    lcd->transport.setdc(lcd->transport.ctx, level);
+    lcd->dc = level;
+}
+
+static void __command(pcd8544_t *lcd, const uint8_t *c, uint16_t n)
+{
+    STATS(lcd->stats.command_bytes += n);
+    __setdc(lcd, DC_COMMAND);
+    lcd->transport.command(lcd->transport.ctx, c, n);
+}
+
+static void __data(pcd8544_t *lcd, const uint8_t *c, uint16_t n)
+{
+    STATS(lcd->stats.data_bytes += n);
+    __setdc(lcd, DC_DATA);
+    lcd->transport.data(lcd->transport.ctx, c, n);
+}
+
+static void __flush(pcd8544_t *lcd)
+{
+    lcd->transport.flush(lcd->transport.ctx);
+}
+
+#ifdef PCD8544_STATS
+static uint64_t __statsnow(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000000000ULL+t.tv_nsec;
+}
+
+/* marks the start of a buffer transfer; d is the dirty state sent, NULL for the whole buffer */
+static void __statsbegin(pcd8544_t *lcd, const dirty_page_t *d)
+{
+    uint8_t p, i;
+    if(d==NULL) lcd->stats.dirty_bytes += LCDBYTES;
+    else
+    {
+        for(p=0; p<LCDPAGES; ++p)
+        {
+            for(i=0; i<d[p].n; ++i) lcd->stats.dirty_bytes += d[p].x1[i]-d[p].x0[i]+1;
+        }
+    }
+    lcd->stats_bytes0 = lcd->stats.command_bytes+lcd->stats.data_bytes;
+    lcd->stats_t0 = __statsnow();
+}
+
+static void __statsend(pcd8544_t *lcd)
+{
+    pcd8544_stats_t *s = &lcd->stats;
+    uint64_t ns = __statsnow()-lcd->stats_t0;
+    uint8_t b;
+    s->last_bytes = (uint32_t)(s->command_bytes+s->data_bytes-lcd->stats_bytes0);
+    if(s->last_bytes>s->max_bytes) s->max_bytes = s->last_bytes;
+    ++s->transfers;
+    s->transfer_ns += ns;
+    if(ns>s->max_transfer_ns) s->max_transfer_ns = ns;
+    for(b=0; (b<(LCD_STATS_BUCKETS-1))&&(ns>>(b+1)); ++b);
+    ++s->transfer_hist[b];
+}
+#endif
+
+static void __setposition(pcd8544_t *lcd, uint8_t x, uint8_t y)
+{
+    uint8_t _xy[2];
+    _xy[0] = x+PCD8544_SETXADDR;
+    _xy[1] = y+PCD8544_SETYADDR;
+    __command(lcd, _xy, 2);
+}
+
+#define DIFF_MERGE_GAP 3 /* unchanged bytes cheaper to resend than a new address */
+
+static uint32_t __load32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint16_t __nextdiff(pcd8544_t *lcd, const uint8_t *buf, uint16_t i, uint16_t end)
+{
+    while(i<end)
+    {
+        if(((i+4)<=end)&&(__load32(buf+i)==__load32(lcd->shadow+i))) i += 4;
+        else if(buf[i]==lcd->shadow[i]) ++i;
+        else break;
+    }
+    return i;
+}
+
+static uint16_t __nextsame(pcd8544_t *lcd, const uint8_t *buf, uint16_t i, uint16_t end)
+{
+    while((i<end)&&(buf[i]!=lcd->shadow[i])) ++i;
+    return i;
+}
+
+/* Sends the changed bytes of buf[start, end) and updates the shadow.
+ * *addr tracks the controller address counter (LCDBYTES when unknown). */
+static void __senddiff(pcd8544_t *lcd, const uint8_t *buf, uint16_t start, uint16_t end, uint16_t *addr)
+{
+    uint16_t i = start, j, k;
+    while((i = __nextdiff(lcd, buf, i, end))<end)
+    {
+        j = __nextsame(lcd, buf, i, end);
+        while(j<end)
+        {
+            k = __nextdiff(lcd, buf, j, end);
+            if((k>=end)||((k-j)>DIFF_MERGE_GAP)) break;
+            j = __nextsame(lcd, buf, k, end);
+        }
+        if(i!=*addr)
+        {
+            if((*addr<i)&&((i-*addr)<=DIFF_MERGE_GAP)) i = *addr;
+            else __setposition(lcd, i%LCDWIDTH, i/LCDWIDTH);
+        }
+        __data(lcd, buf+i, j-i);
+        memcpy(lcd->shadow+i, buf+i, j-i);
+        *addr = (j<LCDBYTES)?j:0;
+        i = j;
+    }
+}
+
+static void __sendall(pcd8544_t *lcd, const uint8_t *buf)
+{
+    uint16_t addr = LCDBYTES;
+    if(lcd->diffmode&&lcd->shadow_valid) __senddiff(lcd, buf, 0, LCDBYTES, &addr);
+    else
+    {
+        __setposition(lcd, 0, 0);
+        __data(lcd, buf, LCDBYTES);
+        if(lcd->diffmode)
+        {
+            memcpy(lcd->shadow, buf, LCDBYTES);
+            lcd->shadow_valid = 1;
+        }
+    }
+    __setposition(lcd, 0, 0);
+}
+
+static void __sendspans(pcd8544_t *lcd, const uint8_t *buf, const dirty_page_t *d)
+{
+    uint8_t p, i, cmd;
+    uint16_t addr = LCDBYTES;
+    if(lcd->diffmode&&!lcd->shadow_valid)
+    {
+        __sendall(lcd, buf);
+        return;
+    }
+    for(p=0; p<LCDPAGES; ++p)
+    {
+        for(i=0; i<d[p].n; ++i)
+        {
+            if(lcd->diffmode) __senddiff(lcd, buf, p*LCDWIDTH+d[p].x0[i], p*LCDWIDTH+d[p].x1[i]+1, &addr);
+            else
+            {
+                __setposition(lcd, d[p].x0[i], p);
+                __data(lcd, buf+(LCDWIDTH*p)+d[p].x0[i], d[p].x1[i]-d[p].x0[i]+1);
+            }
+        }
+    }
+    cmd = PCD8544_SETYADDR;
+    __command(lcd, &cmd, 1);
+}
+
+#define ASYNC_SPANS 1
+#define ASYNC_FULL 2
+
+/* async_enabled only changes on the thread that also makes these calls (see pcd8544_setAsync) */
+static void __buslock(pcd8544_t *lcd)
+{
+    if(lcd->async_enabled) pthread_mutex_lock(&lcd->bus_lock);
+}
+
+static void __busunlock(pcd8544_t *lcd)
+{
+    if(lcd->async_enabled) pthread_mutex_unlock(&lcd->bus_lock);
+}
+
+static void __addns(struct timespec *t, uint32_t ns)
+{
+    t->tv_nsec += ns;
+    while(t->tv_nsec>=1000000000L)
+    {
+        t->tv_nsec -= 1000000000L;
+        ++t->tv_sec;
+    }
+}
+
+static void *__flushworker(void *arg)
+{
+    dirty_page_t d[LCDPAGES];
+    uint8_t *tmp, full, paced = 0;
+    uint32_t interval;
+    struct timespec next;
+    pcd8544_t *lcd = (pcd8544_t*)arg;
+    pthread_mutex_lock(&lcd->flush_lock);
+    for(;;)
+    {
+        while((!lcd->pending)&&(!lcd->flush_stop)) pthread_cond_wait(&lcd->flush_cond, &lcd->flush_lock);
+        if(!lcd->pending) break;
+        interval = lcd->frame_interval_ns;
+        if(paced&&interval)
+        {
+            /* the cap holds back the next frame, which keeps absorbing updates, and never the idle waiters */
+            pthread_mutex_unlock(&lcd->flush_lock);
+            while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL)==EINTR);
+            pthread_mutex_lock(&lcd->flush_lock);
+        }
+        tmp = lcd->back_buffer;
+        lcd->back_buffer = lcd->send_buffer;
+        lcd->send_buffer = tmp;
+        memcpy(d, lcd->back_dirty, sizeof(d));
+        __cleardirty(lcd->back_dirty);
+        full = (lcd->pending==ASYNC_FULL);
+        lcd->pending = 0;
+        lcd->flush_busy = 1;
+        pthread_mutex_unlock(&lcd->flush_lock);
+
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        pthread_mutex_lock(&lcd->bus_lock);
+        STATS(__statsbegin(lcd, full?NULL:d));
+        if(full) __sendall(lcd, lcd->send_buffer);
+        else __sendspans(lcd, lcd->send_buffer, d);
+        __flush(lcd);
+        STATS(__statsend(lcd));
+        pthread_mutex_unlock(&lcd->bus_lock);
+        paced = (interval!=0);
+        if(paced) __addns(&next, interval);
+
+        pthread_mutex_lock(&lcd->flush_lock);
+        lcd->flush_busy = 0;
+        if(!lcd->pending) pthread_cond_broadcast(&lcd->idle_cond);
+    }
+    pthread_mutex_unlock(&lcd->flush_lock);
+    return NULL;
+}
+
+/* hands the drawing buffer over to the flush thread */
+static void __submit(pcd8544_t *lcd, uint8_t full)
+{
+    uint8_t p, i;
+    pthread_mutex_lock(&lcd->flush_lock);
+    memcpy(lcd->back_buffer, lcd->buffer, LCDBYTES);
+    if(full) lcd->pending = ASYNC_FULL;
+    else
+    {
+        for(p=0; p<LCDPAGES; ++p)
+        {
+            for(i=0; i<lcd->dirty[p].n; ++i)
+            {
+                __markdirty(&lcd->back_dirty[p], lcd->dirty[p].x0[i], lcd->dirty[p].x1[i]);
+                if(!lcd->pending) lcd->pending = ASYNC_SPANS;
+            }
+        }
+    }
+    if(lcd->pending) pthread_cond_signal(&lcd->flush_cond);
+    pthread_mutex_unlock(&lcd->flush_lock);
+    __cleardirty(lcd->dirty);
+}
+
+#define FRAME_SKIP 0x00 /* 00nnnnnn: leave n+1 bytes */
+#define FRAME_RUN 0x40 /* 01nnnnnn v: n+1 copies of v */
+#define FRAME_LIT 0x80 /* 1nnnnnnn v...: n+1 literal bytes */
+#define FRAME_RUNVALUE 0xFF /* decoder state: waiting for the value of a run */
+
+/* writes k bytes at linear offset pos (src, or v repeated, xor inv) and marks what changed */
+static void __frameput(pcd8544_t *lcd, uint16_t pos, const uint8_t *src, uint8_t v, uint16_t k, uint8_t inv)
+{
+    uint8_t p, x, first, last, b, changed;
+    while(k)
+    {
+        p = pos/LCDWIDTH;
+        x = pos%LCDWIDTH;
+        changed = 0;
+        first = last = x;
+        for(; k&&(x<LCDWIDTH); --k, ++x, ++pos)
+        {
+            b = (src?*src++:v)^inv;
+            if(lcd->buffer[pos]==b) continue;
+            lcd->buffer[pos] = b;
+            if(!changed) first = x;
+            last = x;
+            changed = 1;
+        }
+        if(changed) __markdirty(&lcd->dirty[p], first, last);
+    }
+}
+
+/** \endcond */
+
+/** \brief Creates a display instance
+ *
+ * Each instance owns its drawing buffer, cursor, text settings, dirty state
+ * and flush thread, so different displays may be drawn to and updated from
+ * different threads. Initialize it with pcd8544_init or pcd8544_inittransport.
+ *
+ * \return pcd8544_t* Display handle, NULL on failure
+ *
+ */
+
+pcd8544_t *pcd8544_create()
+{
+    pcd8544_t *lcd = (pcd8544_t*)calloc(1, sizeof(pcd8544_t));
+    if(lcd==NULL)
+    {
+        printf("Display allocation failed.\n");
+        return NULL;
+    }
+    lcd->buffer = lcd->fb;
+    LCDcanvasInit(&lcd->screen, lcd->fb, LCDWIDTH, LCDHEIGHT, LCDWIDTH);
+    lcd->textsize = 1;
+    lcd->textcolor = BLACK;
+    lcd->textfont = &pcd8544_font5x8;
+    lcd->dc = 0xFF;
+    pthread_mutex_init(&lcd->flush_lock, NULL);
+    pthread_mutex_init(&lcd->bus_lock, NULL);
+    pthread_cond_init(&lcd->flush_cond, NULL);
+    pthread_cond_init(&lcd->idle_cond, NULL);
+    lcd->back_buffer = lcd->async_buffers[0];
+    lcd->send_buffer = lcd->async_buffers[1];
+    return lcd;
+}
+
+/** \brief Destroys a display instance
+ *
+ * Stops the flush thread and releases the transport. The default instance
+ * is only shut down, not freed.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ *
+ */
+
+void pcd8544_destroy(pcd8544_t *lcd)
+{
+    if(lcd==NULL) return;
+    pcd8544_setAsync(lcd, LCD_OFF);
+    if(lcd->transport.close) lcd->transport.close(lcd->transport.ctx);
+    memset(&lcd->transport, 0, sizeof(pcd8544_transport_t));
+    if(lcd==pcd8544_default()) return;
+    pthread_mutex_destroy(&lcd->flush_lock);
+    pthread_mutex_destroy(&lcd->bus_lock);
+    pthread_cond_destroy(&lcd->flush_cond);
+    pthread_cond_destroy(&lcd->idle_cond);
+    free(lcd);
+}
+
+/** \brief Returns the drawing buffer of a display instance
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \return uint8_t* Page-packed drawing buffer (LCDWIDTH*LCDHEIGHT/8 bytes)
+ *
+ */
+
+uint8_t *pcd8544_getbuffer(pcd8544_t *lcd)
+{
+    return lcd->buffer;
+}
+
+/** \brief Initializes the LCD Module
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] SCLK uint8_t Clock
+ * \param[in] DIN uint8_t Data in
+ * \param[in] DC uint8_t Data/Command
+ * \param[in] CS uint8_t Chip Select
+ * \param[in] RST uint8_t Reset
+ * \param[in] contrast uint8_t LCD contrast value (0-127)
+ * \param[in] spi_enabled uint8_t Enable SPI (0/1)
+ *
+ */
+
+void pcd8544_init(pcd8544_t *lcd, uint8_t SCLK, uint8_t DIN, uint8_t DC, uint8_t CS, uint8_t RST, uint8_t contrast, uint8_t spi_enabled)
+{
+    pcd8544_transport_t t;
+    if(spi_enabled)
+    {
+        if(LCDspiTransport(&t, DC, RST)<0) return;
+    }
+    else
+    {
+        if(LCDbitbangTransport(&t, SCLK, DIN, DC, CS, RST)<0) return;
+    }
+    pcd8544_inittransport(lcd, &t, contrast);
+}
+
+/** \brief Initializes the LCD Module over a given transport backend
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] t pcd8544_transport_t* Transport backend (copied)
+ * \param[in] contrast uint8_t LCD contrast value (0-127)
+ *
+ */
+
+void pcd8544_inittransport(pcd8544_t *lcd, const pcd8544_transport_t *t, uint8_t contrast)
+{
+    uint8_t cmd[6];
+    STATS(uint64_t t0 = __statsnow());
+    if((lcd->transport.close)&&(lcd->transport.ctx!=t->ctx)) lcd->transport.close(lcd->transport.ctx);
+    lcd->transport = *t;
+    lcd->dc = 0xFF;
+    lcd->cursor_x = lcd->cursor_y = 0;
+    lcd->textsize = 1;
+    lcd->textcolor = BLACK;
+    if(lcd->transport.reset) lcd->transport.reset(lcd->transport.ctx);
+
+    if(contrast>0x7f) contrast = 0x7f;
+    cmd[0] = PCD8544_FUNCTIONSET|PCD8544_EXTENDEDINSTRUCTION;
+    cmd[1] = PCD8544_SETBIAS|LCD_BIAS;
+    cmd[2] = PCD8544_SETVOP|contrast;
+    //cmd[] = PCD8544_SETTEMP|LCD_TEMP;
+    cmd[3] = PCD8544_SETBIAS|LCD_BIAS;
+    cmd[4] = PCD8544_FUNCTIONSET;
+    cmd[5] = PCD8544_DISPLAYCONTROL|PCD8544_DISPLAYNORMAL;
+    __command(lcd, cmd, 6);
+    pcd8544_clear(lcd);
+    updateBoundingBox(lcd, 0, 0, LCDWIDTH-1, LCDHEIGHT-1);
+    STATS(lcd->stats.init_ns = __statsnow()-t0);
+}
+
+/** \brief Sets LCD power mode
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param mode uint8_t LCD power mode (LCD_ON/LCD_OFF)
+ *
+ */
+
+void pcd8544_setPower(pcd8544_t *lcd, uint8_t mode)
+{
+    pcd8544_command(lcd, (mode==LCD_ON)?0x20:0x24);
+}
+
+/** \brief Displays the Raspberry Pi logo
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ *
+ */
+
+void pcd8544_showLogo(pcd8544_t *lcd)
+{
+#if (LCDWIDTH==84)&&(LCDHEIGHT==48)
+    uint16_t i;
+    for(i=0; i<LCDWIDTH*LCDHEIGHT/8; i+=4)
+    {
+        lcd->buffer[i] = pi_logo[i];
+        lcd->buffer[i+1] = pi_logo[i+1];
+        lcd->buffer[i+2] = pi_logo[i+2];
+        lcd->buffer[i+3] = pi_logo[i+3];
+    }
+#else
+    memset(lcd->buffer, 0, LCDBYTES);
+    __blitbitmap(&lcd->screen, (LCDWIDTH-84)/2, (LCDHEIGHT-48)/2, pi_logo, 84, 48, LCD_ROP_COPY);
+#endif
+    pcd8544_display(lcd);
+}
+
+/** \brief Draws a bitmap with WHITE/BLACK
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] bitmap uint8_t* Raw bitmap
+ * \param[in] w uint8_t Bitmap width
+ * \param[in] h uint8_t Bitmap height
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_drawbitmap(pcd8544_t *lcd, uint8_t x, uint8_t y,const uint8_t *bitmap, uint8_t w, uint8_t h,uint8_t color)
+{
+    __blitbitmap(&lcd->screen, x, y, bitmap, w, h, color?LCD_ROP_OR:LCD_ROP_ANDNOT);
+    updateBoundingBox(lcd, x, y, x+w, y+h);
+}
+
+/** \brief Blits a bitmap with a raster operation and clipping
+ *
+ * The bitmap uses the display's page-packed layout: byte i+(j/8)*w holds
+ * rows j..j+7 of column i, LSB on top.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x int16_t Horizontal position (may be off-screen)
+ * \param[in] y int16_t Vertical position (may be off-screen)
+ * \param[in] bitmap uint8_t* Raw bitmap
+ * \param[in] w uint8_t Bitmap width
+ * \param[in] h uint8_t Bitmap height
+ * \param[in] rop uint8_t Raster operation (LCD_ROP_COPY/LCD_ROP_OR/LCD_ROP_AND/LCD_ROP_ANDNOT/LCD_ROP_XOR/LCD_ROP_INVERT)
+ *
+ */
+
+void pcd8544_blitbitmap(pcd8544_t *lcd, int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t rop)
+{
+    __blitbitmap(&lcd->screen, x, y, bitmap, w, h, rop);
+    updateBoundingBox(lcd, x, y, x+w-1, y+h-1);
+}
+
+/** \brief Draws a full bit-frame
+ *
+ * Only columns whose bytes change are marked dirty.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] bitframe uint8_t* Raw bit-frame
+ * \param[in] type uint8_t Positive/ Negative (LCD_POS/LCD_NEG)
+ *
+ */
+
+void pcd8544_drawbitframe(pcd8544_t *lcd, const uint8_t *bitframe, uint8_t type)
+{
+    __frameput(lcd, 0, bitframe, 0, LCDBYTES, (type==LCD_NEG)?0xFF:0x00);
+}
+
+/** \brief Resets a compressed frame decoder
+ *
+ * \param[out] d pcd8544_rle_t* Decoder state
+ *
+ */
+
+void LCDframeBegin(pcd8544_rle_t *d)
+{
+    d->pos = 0;
+    d->op = 0;
+    d->left = 0;
+}
+
+/** \brief Feeds a chunk of a compressed frame into the drawing buffer
+ *
+ * Chunks may be split anywhere. Decoding stops at the end of the frame,
+ * which is reached once d->pos equals LCDWIDTH*LCDHEIGHT/8, so frames
+ * stored back to back can be fed from one stream. Only columns whose
+ * bytes actually change are marked dirty.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in,out] d pcd8544_rle_t* Decoder state (see LCDframeBegin)
+ * \param[in] data uint8_t* Compressed bytes
+ * \param[in] n uint16_t Number of bytes
+ * \return int Number of bytes consumed, -1 if the data is corrupt
+ *
+ */
+
+int pcd8544_feedFrame(pcd8544_t *lcd, pcd8544_rle_t *d, const uint8_t *data, uint16_t n)
+{
+    uint16_t used = 0, k;
+    uint8_t b;
+    while((used<n)&&((d->pos<LCDBYTES)||d->left))
+    {
+        if(!d->left)
+        {
+            b = data[used++];
+            if(b&FRAME_LIT)
+            {
+                d->op = FRAME_LIT;
+                d->left = (b&0x7F)+1;
+            }
+            else
+            {
+                d->op = (b&FRAME_RUN)?FRAME_RUNVALUE:FRAME_SKIP;
+                d->left = (b&0x3F)+1;
+            }
+            if((d->pos+d->left)>LCDBYTES) return -1;
+            if(d->op==FRAME_SKIP)
+            {
+                d->pos += d->left;
+                d->left = 0;
+            }
+        }
+        else if(d->op==FRAME_RUNVALUE)
+        {
+            __frameput(lcd, d->pos, NULL, data[used++], d->left, 0);
+            d->pos += d->left;
+            d->left = 0;
+        }
+        else
+        {
+            k = n-used;
+            if(k>d->left) k = d->left;
+            __frameput(lcd, d->pos, data+used, 0, k, 0);
+            d->pos += k;
+            d->left -= k;
+            used += k;
+        }
+    }
+    return used;
+}
+
+/** \brief Draws a complete compressed frame
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] data uint8_t* Compressed frame (see LCDencodeFrame)
+ * \param[in] n uint16_t Size of the compressed frame
+ * \return int 0 on success, -1 if the data is corrupt or incomplete
+ *
+ */
+
+int pcd8544_drawframe(pcd8544_t *lcd, const uint8_t *data, uint16_t n)
+{
+    pcd8544_rle_t d;
+    LCDframeBegin(&d);
+    if(pcd8544_feedFrame(lcd, &d, data, n)!=n) return -1;
+    return ((d.pos==LCDBYTES)&&!d.left)?0:-1;
+}
+
+/** \brief Compresses a frame
+ *
+ * Page-packed bytes are coded as runs, literals and, when prev is given,
+ * skips over bytes equal to prev. A frame coded against prev must be drawn
+ * over a buffer that holds prev; one coded without it may be drawn anywhere.
+ *
+ * \param[in] frame uint8_t* Raw frame (LCDWIDTH*LCDHEIGHT/8 bytes)
+ * \param[in] prev uint8_t* Previous raw frame or NULL
+ * \param[out] out uint8_t* Compressed frame
+ * \param[in] size uint16_t Size of out (LCD_FRAME_MAXSIZE always suffices)
+ * \return uint16_t Size of the compressed frame, 0 if it does not fit
+ *
+ */
+
+uint16_t LCDencodeFrame(const uint8_t *frame, const uint8_t *prev, uint8_t *out, uint16_t size)
+{
+    uint16_t i = 0, j, o = 0, k;
+    while(i<LCDBYTES)
+    {
+        for(k=0; prev&&((i+k)<LCDBYTES)&&(k<64)&&(frame[i+k]==prev[i+k]); ++k);
+        if(k>=2)
+        {
+            if(o>=size) return 0;
+            out[o++] = FRAME_SKIP|(k-1);
+            i += k;
+            continue;
+        }
+        for(k=1; ((i+k)<LCDBYTES)&&(k<64)&&(frame[i+k]==frame[i]); ++k);
+        if(k>=3)
+        {
+            if((o+2)>size) return 0;
+            out[o++] = FRAME_RUN|(k-1);
+            out[o++] = frame[i];
+            i += k;
+            continue;
+        }
+        /* a literal ends where a run of 3 or a skip of 2 would pay off */
+        for(j=i+1; (j<LCDBYTES)&&((j-i)<128); ++j)
+        {
+            if(((j+2)<LCDBYTES)&&(frame[j]==frame[j+1])&&(frame[j]==frame[j+2])) break;
+            if(prev&&((j+1)<LCDBYTES)&&(frame[j]==prev[j])&&(frame[j+1]==prev[j+1])) break;
+        }
+        if((o+1+(j-i))>size) return 0;
+        out[o++] = FRAME_LIT|(j-i-1);
+        memcpy(out+o, frame+i, j-i);
+        o += j-i;
+        i = j;
+    }
+    return o;
+}
+
+/** \brief Prints a string
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] c char* String to be printed
+ *
+ */
+
+void pcd8544_drawstring(pcd8544_t *lcd, uint8_t x, uint8_t y, char *c)
+{
+    int16_t box[4] = {LCDWIDTH, LCDHEIGHT, -1, -1};
+    lcd->cursor_x = x;
+    lcd->cursor_y = y;
+    while(*c)
+    {
+        __write(lcd, *c++, box);
+    }
+    updateBoundingBox(lcd, box[0], box[1], box[2], box[3]);
+}
+
+/** \brief Prints a character
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] c char Character to be printed
+ *
+ */
+
+void pcd8544_drawchar(pcd8544_t *lcd, uint8_t x, uint8_t y, char c)
+{
+    if(__drawchar(&lcd->screen, x, y, c, lcd->textfont, lcd->textsize, lcd->textcolor)) updateBoundingBox(lcd, x, y, x+__advance(lcd->textfont, lcd->textsize, c)-1, y+__lineheight(lcd->textfont, lcd->textsize)-1);
+}
+
+/** \brief Prints a character at current position
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] c uint8_t Character to be printed
+ *
+ */
+
+void pcd8544_write(pcd8544_t *lcd, uint8_t c)
+{
+    int16_t box[4] = {LCDWIDTH, LCDHEIGHT, -1, -1};
+    __write(lcd, c, box);
+    updateBoundingBox(lcd, box[0], box[1], box[2], box[3]);
+}
+
+/** \brief Set LCD display mode
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param mode uint8_t Display mode (PCD8544_DISPLAYBLANK/PCD8544_DISPLAYNORMAL/PCD8544_DISPLAYALLON/PCD8544_DISPLAYINVERTED)
+ *
+ */
+
+void pcd8544_setDisplayMode(pcd8544_t *lcd, uint8_t mode)
+{
+    pcd8544_command(lcd, PCD8544_DISPLAYCONTROL|mode);
+}
+
+/** \brief Sets the LCD contrast
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] val uint8_t Contrast value (0-127)
+ *
+ */
+
+void pcd8544_setContrast(pcd8544_t *lcd, uint8_t val)
+{
+    uint8_t cmd[3];
+    if(val>0x7f) val = 0x7f;
+    cmd[0] = PCD8544_FUNCTIONSET|PCD8544_EXTENDEDINSTRUCTION;
+    cmd[1] = PCD8544_SETVOP|val;
+    cmd[2] = PCD8544_FUNCTIONSET;
+    pcd8544_commandArray(lcd, cmd, 3);
+}
+
+/** \brief Sets cursor position
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ *
+ */
+
+void pcd8544_setCursor(pcd8544_t *lcd, uint8_t x, uint8_t y)
+{
+    lcd->cursor_x = x;
+    lcd->cursor_y = y;
+}
+
+/** \brief Sets current position on LCD
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ *
+ */
+
+void pcd8544_setPosition(pcd8544_t *lcd, uint8_t x, uint8_t y)
+{
+    __buslock(lcd);
+    __setposition(lcd, x, y);
+    __flush(lcd);
+    __busunlock(lcd);
+}
+
+/** \brief Sets text size
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param s uint8_t Text size (1-4)
+ *
+ */
+
+void pcd8544_setTextSize(pcd8544_t *lcd, uint8_t s)
+{
+    if(s<1) s = 1;
+    if(s>MAXTEXTSIZE) s = MAXTEXTSIZE;
+    lcd->textsize = s;
+}
+
+/** \brief Sets the font used for text
+ *
+ * The text size only scales the built-in font; other fonts are drawn at
+ * their native size.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param f pcd8544_font_t* Font (NULL - built-in 5x8 font)
+ *
+ */
+
+void pcd8544_setFont(pcd8544_t *lcd, const pcd8544_font_t *f)
+{
+    lcd->textfont = f?f:&pcd8544_font5x8;
+}
+
+/** \brief Measures the width of a string
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] c char* String to be measured
+ * \return uint16_t Advance width of the longest line in pixels
+ *
+ */
+
+uint16_t pcd8544_stringWidth(pcd8544_t *lcd, const char *c)
+{
+    uint16_t w = 0, maxw = 0;
+    for(; *c; ++c)
+    {
+        if(*c=='\n') w = 0;
+        else if(*c!='\r') w += __advance(lcd->textfont, lcd->textsize, *c);
+        if(w>maxw) maxw = w;
+    }
+    return maxw;
+}
+
+/** \brief Measures the height of a string
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] c char* String to be measured
+ * \return uint16_t Height of all lines in pixels
+ *
+ */
+
+uint16_t pcd8544_stringHeight(pcd8544_t *lcd, const char *c)
+{
+    uint16_t lines = 1;
+    if(!*c) return 0;
+    for(; *c; ++c)
+    {
+        if(*c=='\n') ++lines;
+    }
+    return lines*__lineheight(lcd->textfont, lcd->textsize);
+}
+
+/** \brief Sets text color
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param c uint8_t Text color (WHITE/BLACK)
+ *
+ */
+
+void pcd8544_setTextColor(pcd8544_t *lcd, uint8_t c)
+{
+    lcd->textcolor = c;
+}
+
+/** \brief Sets a pixel with color
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t horizontal position
+ * \param[in] y uint8_t vertical position
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_setPixel(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t color)
+{
+    STATS(++lcd->stats.setpixel_calls);
+    if((x>=LCDWIDTH)||(y>=LCDHEIGHT)) return;
+    if(color) lcd->buffer[x+(y/8)*LCDWIDTH] |= _BV(y%8);
+    else lcd->buffer[x+(y/8)*LCDWIDTH] &= ~_BV(y%8);
+    updateBoundingBox(lcd, x, y, x, y);
+}
+
+/** \brief Gets a pixel's value
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \return uint8_t Pixel value
+ *
+ */
+
+uint8_t pcd8544_getPixel(pcd8544_t *lcd, uint8_t x, uint8_t y)
+{
+    if((x>=LCDWIDTH)||(y>=LCDHEIGHT)) return 0;
+    return(lcd->buffer[x+(y/8)*LCDWIDTH]>>(y%8))&0x1;
+}
+
+/** \brief Draws a line.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x0 uint8_t Horizontal start position
+ * \param[in] y0 uint8_t Vertical start position
+ * \param[in] x1 uint8_t Horizontal end position
+ * \param[in] y1 uint8_t Vertical end position
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_drawline(pcd8544_t *lcd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color)
+{
+    uint16_t n = __line(&lcd->screen, x0, y0, x1, y1, color);
+    STATS(lcd->stats.setpixel_calls += n);
+    (void)n;
+    updateBoundingBox(lcd, (x0<x1)?x0:x1, (y0<y1)?y0:y1, (x0<x1)?x1:x0, (y0<y1)?y1:y0);
+}
+
+/** \brief Draws a rectangle.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal start position
+ * \param[in] y uint8_t Vertical start position
+ * \param[in] w uint8_t Width
+ * \param[in] h uint8_t Height
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_drawrect(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color)
+{
+    __rect(&lcd->screen, x, y, w, h, color);
+    updateBoundingBox(lcd, x, y, x+w-1, y+h-1);
+}
+
+/** \brief Draws a filled rectangle.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal start position
+ * \param[in] y uint8_t Vertical start position
+ * \param[in] w uint8_t Width
+ * \param[in] h uint8_t Height
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_fillrect(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t w, uint8_t h,  uint8_t color)
+{
+    __fillrect(&lcd->screen, x, y, x+w-1, y+h-1, color);
+    updateBoundingBox(lcd, x, y, x+w-1, y+h-1);
+}
+
+/** \brief Draws a horizontal line.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal start position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] w uint8_t Width
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_drawhline(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t w, uint8_t color)
+{
+    __fillrect(&lcd->screen, x, y, x+w-1, y, color);
+    updateBoundingBox(lcd, x, y, x+w-1, y);
+}
+
+/** \brief Draws a vertical line.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical start position
+ * \param[in] h uint8_t Height
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_drawvline(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t h, uint8_t color)
+{
+    __fillrect(&lcd->screen, x, y, x, y+h-1, color);
+    updateBoundingBox(lcd, x, y, x, y+h-1);
+}
+
+/** \brief Draws a circle.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x0 uint8_t Horizontal position
+ * \param[in] y0 uint8_t Vertical position
+ * \param[in] r uint8_t Radius
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_drawcircle(pcd8544_t *lcd, uint8_t x0, uint8_t y0, uint8_t r, uint8_t color)
+{
+    uint16_t n = __circle(&lcd->screen, x0, y0, r, color);
+    STATS(lcd->stats.setpixel_calls += n);
+    (void)n;
+    updateBoundingBox(lcd, x0-r, y0-r, x0+r, y0+r);
+}
+
+/** \brief Draws a filled circle.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x0 uint8_t Horizontal position
+ * \param[in] y0 uint8_t Vertical position
+ * \param[in] r uint8_t Radius
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_fillcircle(pcd8544_t *lcd, uint8_t x0, uint8_t y0, uint8_t r, uint8_t color)
+{
+    __fillcircle(&lcd->screen, x0, y0, r, color);
+    updateBoundingBox(lcd, x0-r, y0-r, x0+r, y0+r);
+}
+
+/** \brief Draws a filled triangle.
+ *
+ * Vertices lie on pixel corners and a pixel is filled when its centre is
+ * inside, so shapes sharing an edge do not overlap. Slivers thinner than a
+ * pixel may leave gaps.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x0 int16_t First vertex horizontal position
+ * \param[in] y0 int16_t First vertex vertical position
+ * \param[in] x1 int16_t Second vertex horizontal position
+ * \param[in] y1 int16_t Second vertex vertical position
+ * \param[in] x2 int16_t Third vertex horizontal position
+ * \param[in] y2 int16_t Third vertex vertical position
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_filltriangle(pcd8544_t *lcd, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color)
+{
+    int16_t xy[6];
+    xy[0] = x0;
+    xy[1] = y0;
+    xy[2] = x1;
+    xy[3] = y1;
+    xy[4] = x2;
+    xy[5] = y2;
+    pcd8544_fillpolygon(lcd, xy, 3, color);
+}
+
+/** \brief Draws a filled polygon.
+ *
+ * The polygon may be concave or self-intersecting and is filled with the
+ * even-odd rule, with the vertex convention of pcd8544_filltriangle.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] xy int16_t* Vertices as x, y pairs
+ * \param[in] n uint8_t Number of vertices
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_fillpolygon(pcd8544_t *lcd, const int16_t *xy, uint8_t n, uint8_t color)
+{
+    int16_t xmin = 32767, ymin = 32767, xmax = -32768, ymax = -32768;
+    uint8_t i;
+    if(n<3) return;
+    for(i=0; i<n; ++i)
+    {
+        if(xy[2*i]<xmin) xmin = xy[2*i];
+        if(xy[2*i]>xmax) xmax = xy[2*i];
+        if(xy[2*i+1]<ymin) ymin = xy[2*i+1];
+        if(xy[2*i+1]>ymax) ymax = xy[2*i+1];
+    }
+    __fillpolygon(&lcd->screen, xy, n, color);
+    updateBoundingBox(lcd, xmin, ymin, xmax, ymax);
+}
+
+/** \brief Draws a filled rectangle with rounded corners.
+ *
+ * The corners are quarters of pcd8544_fillcircle of radius r, which is
+ * reduced to fit the rectangle.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x uint8_t Horizontal start position
+ * \param[in] y uint8_t Vertical start position
+ * \param[in] w uint8_t Width
+ * \param[in] h uint8_t Height
+ * \param[in] r uint8_t Corner radius
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void pcd8544_fillroundrect(pcd8544_t *lcd, uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t r, uint8_t color)
 {
-    if((x>=LCDWIDTH)||(y>=LCDHEIGHT)) return;
-    if(color) pcd8544_buffer[x+(y>>3)*LCDWIDTH] |= _BV(y%8);
-    else pcd8544_buffer[x+(y>>3)*LCDWIDTH] &= ~_BV(y%8);
+    __fillroundrect(&lcd->screen, x, y, w, h, r, color);
+    updateBoundingBox(lcd, x, y, x+w-1, y+h-1);
 }
 
-static uint8_t xUpdateMin = (LCDWIDTH-1), xUpdateMax = 0, yUpdateMin = (LCDHEIGHT-1), yUpdateMax = 0;
+/** \brief Draws a filled ellipse.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x0 uint8_t Horizontal position
+ * \param[in] y0 uint8_t Vertical position
+ * \param[in] rx uint8_t Horizontal radius
+ * \param[in] ry uint8_t Vertical radius
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
 
-static void updateBoundingBox(uint8_t xmin, uint8_t ymin, uint8_t xmax, uint8_t ymax)
+void pcd8544_fillellipse(pcd8544_t *lcd, uint8_t x0, uint8_t y0, uint8_t rx, uint8_t ry, uint8_t color)
 {
-    if(xmin<xUpdateMin) xUpdateMin = xmin;
-    if(xmax>xUpdateMax) xUpdateMax = xmax;
-    if(ymin<yUpdateMin) yUpdateMin = ymin;
-    if(ymax>yUpdateMax) yUpdateMax = ymax;
+    __fillellipse(&lcd->screen, x0, y0, rx, ry, color);
+    updateBoundingBox(lcd, x0-rx, y0-ry, x0+rx, y0+ry);
 }
 
-static int idx;
+/** \brief Returns the drawing buffer of a display as a canvas
+ *
+ * Drawing through the canvas is not tracked, so follow it with
+ * pcd8544_invalidate or pcd8544_display. It is also the source to use
+ * with LCDcanvasBlit, e.g. to save what is on screen before a pop-up.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[out] c pcd8544_canvas_t* Canvas
+ *
+ */
 
-/** \endcond */
+void pcd8544_getcanvas(pcd8544_t *lcd, pcd8544_canvas_t *c)
+{
+    *c = lcd->screen;
+}
 
-/** \brief Initializes the LCD Module
+/** \brief Marks a block of the drawing buffer as changed
  *
- * \param[in] SCLK uint8_t Clock
- * \param[in] DIN uint8_t Data in
- * \param[in] DC uint8_t Data/Command
- * \param[in] CS uint8_t Chip Select
- * \param[in] RST uint8_t Reset
- * \param[in] contrast uint8_t LCD contrast value (0-127)
- * \param[in] spi_enabled uint8_t Enable SPI (0/1)
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x int16_t Horizontal position (may be off-screen)
+ * \param[in] y int16_t Vertical position (may be off-screen)
+ * \param[in] w uint16_t Width
+ * \param[in] h uint16_t Height
  *
  */
 
-void LCDInit(uint8_t SCLK, uint8_t DIN, uint8_t DC, uint8_t CS, uint8_t RST, uint8_t contrast, uint8_t spi_enabled)
+void pcd8544_invalidate(pcd8544_t *lcd, int16_t x, int16_t y, uint16_t w, uint16_t h)
 {
-    _din = DIN;
-    _sclk = SCLK;
-    _dc = DC;
-    _rst = RST;
-    _cs = CS;
-    cursor_x = cursor_y = 0;
-    textsize = 1;
-    textcolor = BLACK;
-    if(wiringPiSetup()<0) printf("wiringPi Setup failed.\n");
-    pinMode(_dc, OUTPUT);
-    pinMode(_rst, OUTPUT);
-    if(spi_enabled)
-    {
-        _spi_enabled = spi_enabled;
-        if(wiringPiSPISetup(0, 2000000)<0) printf("SPI Setup failed.\n");
-    }
-    else
-    {
-        pinMode(_sclk, OUTPUT);
-        pinMode(_din, OUTPUT);
-        pinMode(_cs, OUTPUT);
-        idx = setupBitBang(_cs, _din, _sclk, 0);
-    }
-    delay(1);
-    digitalWrite(_rst, LOW);
-    delay(500);
-    digitalWrite(_rst, HIGH);
-
-    LCDcommand(PCD8544_FUNCTIONSET|PCD8544_EXTENDEDINSTRUCTION);
-    LCDcommand(PCD8544_SETBIAS|LCD_BIAS);
-    if(contrast>0x7f) contrast = 0x7f;
-    LCDcommand(PCD8544_SETVOP|contrast);
-    //LCDcommand(PCD8544_SETTEMP|LCD_TEMP);
-    LCDcommand(PCD8544_SETBIAS|LCD_BIAS);
-    LCDcommand(PCD8544_FUNCTIONSET);
-    LCDcommand(PCD8544_DISPLAYCONTROL|PCD8544_DISPLAYNORMAL);
-    LCDclear();
-    updateBoundingBox(0, 0, LCDWIDTH-1, LCDHEIGHT-1);
+    int32_t x1 = x+w-1, y1 = y+h-1;
+    updateBoundingBox(lcd, x, y, (x1<LCDWIDTH)?x1:LCDWIDTH, (y1<LCDHEIGHT)?y1:LCDHEIGHT);
 }
 
-/** \brief Sets LCD power mode
+/** \brief Blits part of a canvas onto the display with a raster operation
  *
- * \param mode uint8_t LCD power mode (LCD_ON/LCD_OFF)
+ * The block is clipped to both the source canvas and the screen.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x int16_t Horizontal position (may be off-screen)
+ * \param[in] y int16_t Vertical position (may be off-screen)
+ * \param[in] src pcd8544_canvas_t* Source canvas
+ * \param[in] sx int16_t Horizontal position in the source
+ * \param[in] sy int16_t Vertical position in the source
+ * \param[in] w uint16_t Width
+ * \param[in] h uint16_t Height
+ * \param[in] rop uint8_t Raster operation (LCD_ROP_COPY/LCD_ROP_OR/LCD_ROP_AND/LCD_ROP_ANDNOT/LCD_ROP_XOR/LCD_ROP_INVERT)
  *
  */
 
-void LCDsetPower(uint8_t mode)
+void pcd8544_blitcanvas(pcd8544_t *lcd, int16_t x, int16_t y, const pcd8544_canvas_t *src, int16_t sx, int16_t sy, uint16_t w, uint16_t h, uint8_t rop)
 {
-    LCDcommand((mode==LCD_ON)?0x20:0x24);
+    int32_t cw = w, ch = h;
+    if(!__clipsource(src, &x, &y, &sx, &sy, &cw, &ch)) return;
+    __blit(&lcd->screen, x, y, src, sx, sy, cw, ch, rop);
+    pcd8544_invalidate(lcd, x, y, cw, ch);
 }
 
-/** \brief Displays the Raspberry Pi logo
+/** \brief Sets up a canvas over a caller-owned buffer
+ *
+ * The buffer needs stride*((h+7)/8) bytes, LCD_CANVAS_SIZE(w, h) when the
+ * stride is the width. A canvas never allocates and is not tied to a
+ * display, so it may be drawn to from any thread that owns it.
  *
+ * \param[out] c pcd8544_canvas_t* Canvas
+ * \param[in] buffer uint8_t* Pixel buffer
+ * \param[in] w uint16_t Width
+ * \param[in] h uint16_t Height
+ * \param[in] stride uint16_t Bytes per 8-row page (0 - the width)
+ * \return int 0 on success, -1 on a bad size
  *
  */
 
-void LCDshowLogo()
+int LCDcanvasInit(pcd8544_canvas_t *c, uint8_t *buffer, uint16_t w, uint16_t h, uint16_t stride)
 {
-    uint16_t i;
-    for(i=0; i<LCDWIDTH*LCDHEIGHT/8; i+=4)
+    if(!stride) stride = w;
+    if((buffer==NULL)||!w||!h||(stride<w))
     {
-        pcd8544_buffer[i] = pi_logo[i];
-        pcd8544_buffer[i+1] = pi_logo[i+1];
-        pcd8544_buffer[i+2] = pi_logo[i+2];
-        pcd8544_buffer[i+3] = pi_logo[i+3];
+        printf("Invalid canvas.\n");
+        return -1;
     }
-    LCDdisplay();
+    c->buffer = buffer;
+    c->width = w;
+    c->height = h;
+    c->stride = stride;
+    return 0;
 }
 
-/** \brief Draws a bitmap with WHITE/BLACK
+/** \brief Fills a whole canvas
  *
- * \param[in] x uint8_t Horizontal position
- * \param[in] y uint8_t Vertical position
- * \param[in] bitmap uint8_t* Raw bitmap
- * \param[in] w uint8_t Bitmap width
- * \param[in] h uint8_t Bitmap height
+ * \param[in] c pcd8544_canvas_t* Canvas
  * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDdrawbitmap(uint8_t x, uint8_t y,const uint8_t *bitmap, uint8_t w, uint8_t h,uint8_t color)
+void LCDcanvasFill(const pcd8544_canvas_t *c, uint8_t color)
 {
-    uint8_t j,i;
-    for(j=0; j<h; ++j)
-    {
-        for(i=0; i<w; ++i)
-        {
-            if(*(bitmap+i+(j/8)*w)&_BV(j%8))
-            {
-                __setpixel(x+i, y+j, color);
-            }
-        }
-    }
-    updateBoundingBox(x, y, x+w, y+h);
+    __fillblock(c, 0, 0, c->width-1, c->height-1, color);
 }
 
-/** \brief Draws a full bit-frame
+/** \brief Sets a pixel of a canvas
  *
- * \param[in] bitframe uint8_t* Raw bit-frame
- * \param[in] type uint8_t Positive/ Negative (LCD_POS/LCD_NEG)
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical position
+ * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDdrawbitframe(const uint8_t *bitframe, uint8_t type)
+void LCDcanvasSetPixel(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint8_t color)
 {
-    uint16_t i;
-    if(type==LCD_NEG)
-    {
-        for(i=0; i<LCDWIDTH*LCDHEIGHT/8; i+=4)
-        {
-            pcd8544_buffer[i] = ~bitframe[i];
-            pcd8544_buffer[i+1] = ~bitframe[i+1];
-            pcd8544_buffer[i+2] = ~bitframe[i+2];
-            pcd8544_buffer[i+3] = ~bitframe[i+3];
-        }
-    }
-    else
-    {
-        for(i=0; i<LCDWIDTH*LCDHEIGHT/8; i+=4)
-        {
-            pcd8544_buffer[i] = bitframe[i];
-            pcd8544_buffer[i+1] = bitframe[i+1];
-            pcd8544_buffer[i+2] = bitframe[i+2];
-            pcd8544_buffer[i+3] = bitframe[i+3];
-        }
-    }
-    updateBoundingBox(0, 0, (LCDWIDTH-1), (LCDHEIGHT-1));
+    __setpixel(c, x, y, color);
 }
 
-/** \brief Prints a string
+/** \brief Gets a pixel of a canvas
  *
- * \param[in] x uint8_t Horizontal position
- * \param[in] y uint8_t Vertical position
- * \param[in] c char* String to be printed
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical position
+ * \return uint8_t Pixel value (0 outside the canvas)
  *
  */
 
-void LCDdrawstring(uint8_t x, uint8_t y, char *c)
+uint8_t LCDcanvasGetPixel(const pcd8544_canvas_t *c, int16_t x, int16_t y)
 {
-    cursor_x = x;
-    cursor_y = y;
-    while(*c)
-    {
-        LCDwrite(*c++);
-    }
+    if((x<0)||(y<0)||(x>=c->width)||(y>=c->height)) return 0;
+    return (c->buffer[x+(y>>3)*c->stride]>>(y&7))&0x1;
 }
 
-/** \brief  Prints a character
+/** \brief Draws a line on a canvas
  *
- * \param[in] x uint8_t Horizontal position
- * \param[in] y uint8_t Vertical position
- * \param[in] c char Character to be printed
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x0 int16_t Horizontal start position
+ * \param[in] y0 int16_t Vertical start position
+ * \param[in] x1 int16_t Horizontal end position
+ * \param[in] y1 int16_t Vertical end position
+ * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDdrawchar(uint8_t x, uint8_t y, char c)
+void LCDcanvasDrawline(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color)
 {
-    if(y>=LCDHEIGHT) return;
-    if((x+5)>=LCDWIDTH) return;
-    uint8_t i,j;
-    for(i=0; i<5; ++i)
-    {
-        uint8_t d = *(font+(c*5)+i);
-        uint8_t j;
-        for(j=0; j<8; ++j)
-        {
-            if(d&_BV(j)) __setpixel(x+i, y+j, textcolor);
-            else __setpixel(x+i, y+j, !textcolor);
-        }
-    }
-
-    for(j=0; j<8; ++j)
-    {
-        __setpixel(x+5, y+j, !textcolor);
-    }
-    updateBoundingBox(x, y, x+5, y+8);
+    __line(c, x0, y0, x1, y1, color);
 }
 
-/** \brief  Prints a character at current position
+/** \brief Draws a rectangle on a canvas
  *
- * \param[in] c uint8_t Character to be printed
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal start position
+ * \param[in] y int16_t Vertical start position
+ * \param[in] w uint16_t Width
+ * \param[in] h uint16_t Height
+ * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDwrite(uint8_t c)
+void LCDcanvasDrawrect(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t color)
 {
-    if(c=='\n')
-    {
-        cursor_y += textsize*8;
-        if(cursor_y>=LCDHEIGHT) cursor_y = 0;
-        cursor_x = 0;
-    }
-    else if(c!='\r')
-    {
-        LCDdrawchar(cursor_x, cursor_y, c);
-        cursor_x += textsize*6;
-        if(cursor_x>=(LCDWIDTH-5))
-        {
-            cursor_x = 0;
-            cursor_y += textsize*8;
-        }
-        if(cursor_y>=LCDHEIGHT) cursor_y = 0;
-    }
+    __rect(c, x, y, w, h, color);
 }
 
-/** \brief Set LCD display mode
+/** \brief Draws a filled rectangle on a canvas
  *
- * \param mode uint8_t Display mode (PCD8544_DISPLAYBLANK/PCD8544_DISPLAYNORMAL/PCD8544_DISPLAYALLON/PCD8544_DISPLAYINVERTED)
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal start position
+ * \param[in] y int16_t Vertical start position
+ * \param[in] w uint16_t Width
+ * \param[in] h uint16_t Height
+ * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDsetDisplayMode(uint8_t mode)
+void LCDcanvasFillrect(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t color)
 {
-    LCDcommand(PCD8544_DISPLAYCONTROL|mode);
+    __fillrect(c, x, y, x+w-1, y+h-1, color);
 }
 
-/** \brief Sets the LCD contrast
+/** \brief Draws a horizontal line on a canvas
  *
- * \param[in] val uint8_t Contrast value (0-127)
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal start position
+ * \param[in] y int16_t Vertical position
+ * \param[in] w uint16_t Width
+ * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDsetContrast(uint8_t val)
+void LCDcanvasDrawhline(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t w, uint8_t color)
 {
-    if(val>0x7f) val = 0x7f;
-    LCDcommand(PCD8544_FUNCTIONSET|PCD8544_EXTENDEDINSTRUCTION);
-    LCDcommand(PCD8544_SETVOP|val);
-    LCDcommand(PCD8544_FUNCTIONSET);
+    __fillrect(c, x, y, x+w-1, y, color);
 }
 
-/** \brief Sets cursor position
+/** \brief Draws a vertical line on a canvas
  *
- * \param[in] x uint8_t Horizontal position
- * \param[in] y uint8_t Vertical position
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical start position
+ * \param[in] h uint16_t Height
+ * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDsetCursor(uint8_t x, uint8_t y)
+void LCDcanvasDrawvline(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t h, uint8_t color)
 {
-    cursor_x = x;
-    cursor_y = y;
+    __fillrect(c, x, y, x, y+h-1, color);
 }
 
-/** \brief Sets current position on LCD
+/** \brief Draws a circle on a canvas
  *
- * \param[in] x uint8_t Horizontal position
- * \param[in] y uint8_t Vertical position
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x0 int16_t Horizontal position
+ * \param[in] y0 int16_t Vertical position
+ * \param[in] r uint8_t Radius
+ * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDsetPosition(uint8_t x, uint8_t y)
+void LCDcanvasDrawcircle(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, uint8_t r, uint8_t color)
 {
-    static uint8_t _xy[2];
-    _xy[0] = x+PCD8544_SETXADDR;
-    _xy[1] = y+PCD8544_SETYADDR;
-    LCDcommandArray(_xy, 2);
+    __circle(c, x0, y0, r, color);
 }
 
-/** \brief Sets text size
+/** \brief Draws a filled circle on a canvas
  *
- * \param s uint8_t Text size
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x0 int16_t Horizontal position
+ * \param[in] y0 int16_t Vertical position
+ * \param[in] r uint8_t Radius
+ * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDsetTextSize(uint8_t s)
+void LCDcanvasFillcircle(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, uint8_t r, uint8_t color)
 {
-    textsize = s;
+    __fillcircle(c, x0, y0, r, color);
 }
 
-/** \brief Sets text color
+/** \brief Draws a filled triangle on a canvas (see pcd8544_filltriangle)
  *
- * \param c uint8_t Text color (WHITE/BLACK)
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x0 int16_t First vertex horizontal position
+ * \param[in] y0 int16_t First vertex vertical position
+ * \param[in] x1 int16_t Second vertex horizontal position
+ * \param[in] y1 int16_t Second vertex vertical position
+ * \param[in] x2 int16_t Third vertex horizontal position
+ * \param[in] y2 int16_t Third vertex vertical position
+ * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDsetTextColor(uint8_t c)
+void LCDcanvasFilltriangle(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color)
 {
-    textcolor = c;
+    int16_t xy[6];
+    xy[0] = x0;
+    xy[1] = y0;
+    xy[2] = x1;
+    xy[3] = y1;
+    xy[4] = x2;
+    xy[5] = y2;
+    __fillpolygon(c, xy, 3, color);
 }
 
-/** \brief Sets a pixel with color
+/** \brief Draws a filled polygon on a canvas (see pcd8544_fillpolygon)
  *
- * \param[in] x uint8_t horizontal position
- * \param[in] y uint8_t vertical position
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] xy int16_t* Vertices as x, y pairs
+ * \param[in] n uint8_t Number of vertices
  * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDsetPixel(uint8_t x, uint8_t y, uint8_t color)
+void LCDcanvasFillpolygon(const pcd8544_canvas_t *c, const int16_t *xy, uint8_t n, uint8_t color)
 {
-    if((x>=LCDWIDTH)||(y>=LCDHEIGHT)) return;
-    if(color) pcd8544_buffer[x+(y/8)*LCDWIDTH] |= _BV(y%8);
-    else pcd8544_buffer[x+(y/8)*LCDWIDTH] &= ~_BV(y%8);
-    updateBoundingBox(x, y, x, y);
+    __fillpolygon(c, xy, n, color);
 }
 
-/** \brief Gets a pixel's value
+/** \brief Draws a filled rectangle with rounded corners on a canvas
  *
- * \param[in] x uint8_t Horizontal position
- * \param[in] y uint8_t Vertical position
- * \return uint8_t Pixel value
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal start position
+ * \param[in] y int16_t Vertical start position
+ * \param[in] w uint16_t Width
+ * \param[in] h uint16_t Height
+ * \param[in] r uint8_t Corner radius
+ * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-uint8_t LCDgetPixel(uint8_t x, uint8_t y)
+void LCDcanvasFillroundrect(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t r, uint8_t color)
 {
-    if((x>=LCDWIDTH)||(y>=LCDHEIGHT)) return 0;
-    return(pcd8544_buffer[x+(y/8)*LCDWIDTH]>>(7-(y%8)))&0x1;
+    __fillroundrect(c, x, y, w, h, r, color);
 }
 
-/** \brief Draws a line.
+/** \brief Draws a filled ellipse on a canvas
  *
- * \param[in] x0 uint8_t Horizontal start position
- * \param[in] y0 uint8_t Vertical start position
- * \param[in] x1 uint8_t Horizontal end position
- * \param[in] y1 uint8_t Vertical end position
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x0 int16_t Horizontal position
+ * \param[in] y0 int16_t Vertical position
+ * \param[in] rx uint8_t Horizontal radius
+ * \param[in] ry uint8_t Vertical radius
  * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDdrawline(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color)
+void LCDcanvasFillellipse(const pcd8544_canvas_t *c, int16_t x0, int16_t y0, uint8_t rx, uint8_t ry, uint8_t color)
 {
-    uint8_t steep = abs(y1-y0)>abs(x1-x0);
-    if(steep)
-    {
-        swap(x0, y0);
-        swap(x1, y1);
-    }
-    if(x0>x1)
-    {
-        swap(x0, x1);
-        swap(y0, y1);
-    }
-    updateBoundingBox(x0, y0, x1, y1);
-    uint8_t dx, dy;
-    dx = x1-x0;
-    dy = abs(y1-y0);
-    int8_t err = dx/2;
-    int8_t ystep;
-
-    if(y0<y1) ystep = 1;
-    else ystep = -1;
-    for(; x0<=x1; ++x0)
-    {
-        if(steep) __setpixel(y0, x0, color);
-        else __setpixel(x0, y0, color);
-        err -= dy;
-        if(err<0)
-        {
-            y0 += ystep;
-            err += dx;
-        }
-    }
+    __fillellipse(c, x0, y0, rx, ry, color);
 }
 
-/** \brief Draws a rectangle.
+/** \brief Blits a bitmap onto a canvas with a raster operation and clipping
  *
- * \param[in] x uint8_t Horizontal start position
- * \param[in] y uint8_t Vertical start position
- * \param[in] w uint8_t Width
- * \param[in] h uint8_t Height
- * \param[in] color uint8_t WHITE/BLACK
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical position
+ * \param[in] bitmap uint8_t* Page-packed bitmap (stride w)
+ * \param[in] w uint16_t Bitmap width
+ * \param[in] h uint16_t Bitmap height
+ * \param[in] rop uint8_t Raster operation (LCD_ROP_COPY/LCD_ROP_OR/LCD_ROP_AND/LCD_ROP_ANDNOT/LCD_ROP_XOR/LCD_ROP_INVERT)
  *
  */
 
-void LCDdrawrect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color)
+void LCDcanvasBlitbitmap(const pcd8544_canvas_t *c, int16_t x, int16_t y, const uint8_t *bitmap, uint16_t w, uint16_t h, uint8_t rop)
 {
-    uint8_t i;
-    for(i=x; i<x+w; ++i)
-    {
-        __setpixel(i, y, color);
-        __setpixel(i, y+h-1, color);
-    }
-    for(i=y; i<y+h; ++i)
-    {
-        __setpixel(x, i, color);
-        __setpixel(x+w-1, i, color);
-    }
-    updateBoundingBox(x, y, x+w, y+h);
+    __blitbitmap(c, x, y, bitmap, w, h, rop);
 }
 
-/** \brief Draws a filled rectangle.
+/** \brief Blits part of one canvas onto another with a raster operation
  *
- * \param[in] x uint8_t Horizontal start position
- * \param[in] y uint8_t Vertical start position
- * \param[in] w uint8_t Width
- * \param[in] h uint8_t Height
- * \param[in] color uint8_t WHITE/BLACK
+ * The block is clipped to both canvases, which must not overlap in memory.
+ *
+ * \param[in] dst pcd8544_canvas_t* Destination canvas
+ * \param[in] x int16_t Horizontal position in the destination
+ * \param[in] y int16_t Vertical position in the destination
+ * \param[in] src pcd8544_canvas_t* Source canvas
+ * \param[in] sx int16_t Horizontal position in the source
+ * \param[in] sy int16_t Vertical position in the source
+ * \param[in] w uint16_t Width
+ * \param[in] h uint16_t Height
+ * \param[in] rop uint8_t Raster operation (LCD_ROP_COPY/LCD_ROP_OR/LCD_ROP_AND/LCD_ROP_ANDNOT/LCD_ROP_XOR/LCD_ROP_INVERT)
  *
  */
 
-void LCDfillrect(uint8_t x, uint8_t y, uint8_t w, uint8_t h,  uint8_t color)
+void LCDcanvasBlit(const pcd8544_canvas_t *dst, int16_t x, int16_t y, const pcd8544_canvas_t *src, int16_t sx, int16_t sy, uint16_t w, uint16_t h, uint8_t rop)
 {
-    uint8_t i,j;
-    for(i=x; i<x+w; ++i)
-    {
-        for(j=y; j<y+h; ++j)
-        {
-            __setpixel(i, j, color);
-        }
-    }
-    updateBoundingBox(x, y, x+w, y+h);
+    int32_t cw = w, ch = h;
+    if(!__clipsource(src, &x, &y, &sx, &sy, &cw, &ch)) return;
+    __blit(dst, x, y, src, sx, sy, cw, ch, rop);
 }
 
-/** \brief Draws a circle.
+/** \brief Prints a character on a canvas
  *
- * \param[in] x0 uint8_t Horizontal position
- * \param[in] y0 uint8_t Vertical position
- * \param[in] r uint8_t Radius
+ * A character that does not fit on the right is skipped, as on the display.
+ *
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical position
+ * \param[in] ch char Character
+ * \param[in] f pcd8544_font_t* Font (NULL - built-in 5x8 font)
+ * \param[in] s uint8_t Text size (scales the built-in font only)
  * \param[in] color uint8_t WHITE/BLACK
+ * \return uint8_t Horizontal advance in pixels
  *
  */
 
-void LCDdrawcircle(uint8_t x0, uint8_t y0, uint8_t r, uint8_t color)
+uint8_t LCDcanvasDrawchar(const pcd8544_canvas_t *c, int16_t x, int16_t y, char ch, const pcd8544_font_t *f, uint8_t s, uint8_t color)
 {
-    updateBoundingBox(x0-r, y0-r, x0+r, y0+r);
-    int8_t f = 1-r;
-    int8_t ddF_x = 1;
-    int8_t ddF_y = -2*r;
-    int8_t x = 0;
-    int8_t y = r;
-    __setpixel(x0, y0+r, color);
-    __setpixel(x0, y0-r, color);
-    __setpixel(x0+r, y0, color);
-    __setpixel(x0-r, y0, color);
-    while(x<y)
-    {
-        if(f>=0)
-        {
-            --y;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        ++x;
-        ddF_x += 2;
-        f += ddF_x;
-        __setpixel(x0+x, y0+y, color);
-        __setpixel(x0-x, y0+y, color);
-        __setpixel(x0+x, y0-y, color);
-        __setpixel(x0-x, y0-y, color);
-        __setpixel(x0+y, y0+x, color);
-        __setpixel(x0-y, y0+x, color);
-        __setpixel(x0+y, y0-x, color);
-        __setpixel(x0-y, y0-x, color);
-    }
+    if(f==NULL) f = &pcd8544_font5x8;
+    if(s<1) s = 1;
+    if(s>MAXTEXTSIZE) s = MAXTEXTSIZE;
+    __drawchar(c, x, y, ch, f, s, color);
+    return __advance(f, s, ch);
 }
 
-/** \brief Draws a filled circle.
+/** \brief Prints a string on a canvas
  *
- * \param[in] x0 uint8_t Horizontal position
- * \param[in] y0 uint8_t Vertical position
- * \param[in] r uint8_t Radius
+ * There is no wrapping; a newline goes back to x one line lower.
+ *
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical position
+ * \param[in] str char* String
+ * \param[in] f pcd8544_font_t* Font (NULL - built-in 5x8 font)
+ * \param[in] s uint8_t Text size (scales the built-in font only)
  * \param[in] color uint8_t WHITE/BLACK
  *
  */
 
-void LCDfillcircle(uint8_t x0, uint8_t y0, uint8_t r, uint8_t color)
+void LCDcanvasDrawstring(const pcd8544_canvas_t *c, int16_t x, int16_t y, const char *str, const pcd8544_font_t *f, uint8_t s, uint8_t color)
 {
-    updateBoundingBox(x0-r, y0-r, x0+r, y0+r);
-    int8_t f = 1 - r;
-    int8_t ddF_x = 1;
-    int8_t ddF_y = -2 * r;
-    int8_t x = 0;
-    int8_t y = r;
-    uint8_t i;
-
-    for(i=y0-r; i<=y0+r; ++i)
-    {
-        __setpixel(x0, i, color);
-    }
-
-    while(x<y)
+    int16_t cx = x;
+    if(f==NULL) f = &pcd8544_font5x8;
+    if(s<1) s = 1;
+    if(s>MAXTEXTSIZE) s = MAXTEXTSIZE;
+    for(; *str; ++str)
     {
-        if(f>=0)
-        {
-            --y;
-            ddF_y += 2;
-            f += ddF_y;
-        }
-        ++x;
-        ddF_x += 2;
-        f += ddF_x;
-        for(i=y0-y; i<=y0+y; ++i)
+        if(*str=='\n')
         {
-            __setpixel(x0+x, i, color);
-            __setpixel(x0-x, i, color);
+            cx = x;
+            y += __lineheight(f, s);
         }
-        for(i=y0-x; i<=y0+x; ++i)
+        else if(*str!='\r')
         {
-            __setpixel(x0+y, i, color);
-            __setpixel(x0-y, i, color);
+            __drawchar(c, cx, y, *str, f, s, color);
+            cx += __advance(f, s, *str);
         }
     }
 }
 
 /** \brief Writes out a byte
  *
+ * \param[in] lcd pcd8544_t* Display handle
  * \param[in] c uint8_t Byte
  *
  */
 
-void LCDspiwrite(uint8_t c)
+void pcd8544_spiwrite(pcd8544_t *lcd, uint8_t c)
 {
-    if(_spi_enabled) wiringPiSPIDataRW(0, &c, 1);
-    else digitalWriteSerial(idx, c);
+    __buslock(lcd);
+    lcd->shadow_valid = 0;
+    STATS(*((lcd->dc==DC_DATA)?&lcd->stats.data_bytes:&lcd->stats.command_bytes) += 1);
+    if(lcd->dc==DC_DATA) lcd->transport.data(lcd->transport.ctx, &c, 1);
+    else lcd->transport.command(lcd->transport.ctx, &c, 1);
+    __flush(lcd);
+    __busunlock(lcd);
 }
 
 /** \brief Writes out an array
  *
+ * \param[in] lcd pcd8544_t* Display handle
  * \param[in] c uint8_t* Array
- * \param[in] n uint16_t Size of array (max - LCDWIDTH*LCDHEIGHT/8)
+ * \param[in] n uint16_t Size of array
  *
  */
 
-void LCDspiwriteArray(uint8_t *c, uint16_t n)
+void pcd8544_spiwriteArray(pcd8544_t *lcd, uint8_t *c, uint16_t n)
 {
-    if(_spi_enabled)
-    {
-        if(n>(LCDWIDTH*LCDHEIGHT/8)) n = (LCDWIDTH*LCDHEIGHT/8);
-        memcpy(pcd8544_buffer2, c, n);
-        wiringPiSPIDataRW(0, pcd8544_buffer2, n);
-    }
-    else digitalWriteSerialArray(idx, c, n);
+    __buslock(lcd);
+    lcd->shadow_valid = 0;
+    STATS(*((lcd->dc==DC_DATA)?&lcd->stats.data_bytes:&lcd->stats.command_bytes) += n);
+    if(lcd->dc==DC_DATA) lcd->transport.data(lcd->transport.ctx, c, n);
+    else lcd->transport.command(lcd->transport.ctx, c, n);
+    __flush(lcd);
+    __busunlock(lcd);
 }
 
 /** \brief Writes out a command byte
  *
+ * \param[in] lcd pcd8544_t* Display handle
  * \param[in] c uint8_t Command
  *
  */
 
-void LCDcommand(uint8_t c)
+void pcd8544_command(pcd8544_t *lcd, uint8_t c)
 {
-    digitalWrite(_dc, LOW);
-    LCDspiwrite(c);
+    __buslock(lcd);
+    __command(lcd, &c, 1);
+    __flush(lcd);
+    __busunlock(lcd);
 }
 
 /** \brief Writes out a command array
  *
+ * \param[in] lcd pcd8544_t* Display handle
  * \param[in] c uint8_t* Command array
  * \param[in] n uint16_t Size of array
  *
  */
 
-void LCDcommandArray(uint8_t *c, uint16_t n)
+void pcd8544_commandArray(pcd8544_t *lcd, uint8_t *c, uint16_t n)
 {
-    digitalWrite(_dc, LOW);
-    LCDspiwriteArray(c, n);
+    __buslock(lcd);
+    __command(lcd, c, n);
+    __flush(lcd);
+    __busunlock(lcd);
 }
 
 /** \brief Writes out a data byte
  *
+ * \param[in] lcd pcd8544_t* Display handle
  * \param[in] c uint8_t Data
  *
  */
 
-void LCDdata(uint8_t c)
+void pcd8544_data(pcd8544_t *lcd, uint8_t c)
 {
-    digitalWrite(_dc, HIGH);
-    LCDspiwrite(c);
+    __buslock(lcd);
+    lcd->shadow_valid = 0;
+    __data(lcd, &c, 1);
+    __flush(lcd);
+    __busunlock(lcd);
 }
 
 /** \brief Writes out a data array
  *
+ * \param[in] lcd pcd8544_t* Display handle
  * \param[in] c uint8_t* Data array
  * \param[in] n uint16_t Size of array
  *
  */
 
-void LCDdataArray(uint8_t *c, uint16_t n)
+void pcd8544_dataArray(pcd8544_t *lcd, uint8_t *c, uint16_t n)
+{
+    __buslock(lcd);
+    lcd->shadow_valid = 0;
+    __data(lcd, c, n);
+    __flush(lcd);
+    __busunlock(lcd);
+}
+
+/** \brief Sets the shadow-framebuffer diff mode
+ *
+ * In diff mode a copy of the panel contents is kept and LCDupdate,
+ * LCDdisplay and LCDclear send only the bytes that actually changed.
+ * The panel is resynchronised with a full transfer on the next update.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] mode uint8_t Diff mode (LCD_ON/LCD_OFF)
+ *
+ */
+
+void pcd8544_setDiffMode(pcd8544_t *lcd, uint8_t mode)
+{
+    __buslock(lcd);
+    lcd->diffmode = (mode==LCD_ON);
+    lcd->shadow_valid = 0;
+    __busunlock(lcd);
+}
+
+/** \brief Sets the asynchronous flush mode
+ *
+ * In async mode LCDupdate, LCDdisplay and LCDclear hand a snapshot of the
+ * drawing buffer to a background thread and return immediately. Frames
+ * submitted faster than the bus drains are coalesced so the latest one is
+ * always sent. Turning async mode off waits for pending frames first.
+ * The mode is not locked: switch it only from the one thread that draws
+ * and talks to the display, while no other call on it is in progress.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] mode uint8_t Async mode (LCD_ON/LCD_OFF)
+ *
+ */
+
+void pcd8544_setAsync(pcd8544_t *lcd, uint8_t mode)
+{
+    if((mode==LCD_ON)==lcd->async_enabled) return;
+    if(mode==LCD_ON)
+    {
+        lcd->flush_stop = 0;
+        lcd->async_enabled = 1;
+        if(pthread_create(&lcd->flush_thread, NULL, __flushworker, lcd)!=0)
+        {
+            lcd->async_enabled = 0;
+            printf("Flush thread creation failed.\n");
+        }
+    }
+    else
+    {
+        pthread_mutex_lock(&lcd->flush_lock);
+        lcd->flush_stop = 1;
+        pthread_cond_signal(&lcd->flush_cond);
+        pthread_mutex_unlock(&lcd->flush_lock);
+        pthread_join(lcd->flush_thread, NULL);
+        lcd->async_enabled = 0;
+    }
+}
+
+/** \brief Waits until all submitted frames have been sent
+ *
+ * Like pcd8544_setAsync, call it from the thread that draws.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ *
+ */
+
+void pcd8544_waitFlush(pcd8544_t *lcd)
+{
+    if(!lcd->async_enabled) return;
+    pthread_mutex_lock(&lcd->flush_lock);
+    while(lcd->pending||lcd->flush_busy) pthread_cond_wait(&lcd->idle_cond, &lcd->flush_lock);
+    pthread_mutex_unlock(&lcd->flush_lock);
+}
+
+/** \brief Caps the asynchronous flush rate
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] fps uint16_t Maximum frames per second (0 - unlimited)
+ *
+ */
+
+void pcd8544_setFrameRateCap(pcd8544_t *lcd, uint16_t fps)
 {
-    digitalWrite(_dc, HIGH);
-    LCDspiwriteArray(c, n);
+    pthread_mutex_lock(&lcd->flush_lock);
+    lcd->frame_interval_ns = fps?(1000000000UL/fps):0;
+    pthread_mutex_unlock(&lcd->flush_lock);
 }
 
 /** \brief Resets the drawing buffer
  *
+ * \param[in] lcd pcd8544_t* Display handle
  *
  */
 
-void LCDzero(void)
+void pcd8544_zero(pcd8544_t *lcd)
 {
-    memset(pcd8544_buffer, 0, LCDWIDTH*LCDHEIGHT/8);
-    xUpdateMin = 0;
-    xUpdateMax = (LCDWIDTH-1);
-    yUpdateMin = 0;
-    yUpdateMax = (LCDHEIGHT-1);
+    memset(lcd->buffer, 0, LCDWIDTH*LCDHEIGHT/8);
+    updateBoundingBox(lcd, 0, 0, (LCDWIDTH-1), (LCDHEIGHT-1));
 }
 
 /** \brief Displays the drawing buffer
  *
+ * \param[in] lcd pcd8544_t* Display handle
  *
  */
 
-void LCDdisplay(void)
+void pcd8544_display(pcd8544_t *lcd)
 {
-    LCDsetPosition(0,0);
-    LCDdataArray(pcd8544_buffer, LCDWIDTH*LCDHEIGHT/8);
-    LCDsetPosition(0,0);
-    xUpdateMin = (LCDWIDTH-1);
-    xUpdateMax = 0;
-    yUpdateMin = (LCDHEIGHT-1);
-    yUpdateMax = 0;
+    STATS(++lcd->stats.displays);
+    if(lcd->async_enabled)
+    {
+        __submit(lcd, 1);
+        return;
+    }
+    STATS(__statsbegin(lcd, NULL));
+    __sendall(lcd, lcd->buffer);
+    __flush(lcd);
+    STATS(__statsend(lcd));
+    __cleardirty(lcd->dirty);
 }
 
 /** \brief Updates the LCD
  *
+ * Only the dirty column spans of each 8-row page are sent.
+ * \param[in] lcd pcd8544_t* Display handle
  *
  */
 
-void LCDupdate(void)
+void pcd8544_update(pcd8544_t *lcd)
 {
-    uint8_t p, pp;
-    for(p=0; p<48; p+=8)
+    STATS(++lcd->stats.updates);
+    if(lcd->async_enabled)
     {
-        if(yUpdateMin>=(p+8)) continue;
-        if(yUpdateMax<p) break;
-        pp = p>>3;
-        LCDcommand(PCD8544_SETYADDR|(pp));
-        LCDcommand(PCD8544_SETXADDR|xUpdateMin);
-        LCDdataArray(pcd8544_buffer+(LCDWIDTH*pp)+xUpdateMin, (xUpdateMax-xUpdateMin));
+        __submit(lcd, 0);
+        return;
     }
-    LCDcommand(PCD8544_SETYADDR);
-    xUpdateMin = (LCDWIDTH-1);
-    xUpdateMax = 0;
-    yUpdateMin = (LCDHEIGHT-1);
-    yUpdateMax = 0;
+    STATS(__statsbegin(lcd, lcd->dirty));
+    __sendspans(lcd, lcd->buffer, lcd->dirty);
+    __flush(lcd);
+    STATS(__statsend(lcd));
+    __cleardirty(lcd->dirty);
 }
 
 /** \brief Clears the LCD
  *
+ * \param[in] lcd pcd8544_t* Display handle
+ *
+ */
+
+void pcd8544_clear(pcd8544_t *lcd)
+{
+    memset(lcd->buffer, 0, LCDWIDTH*LCDHEIGHT/8);
+    STATS(++lcd->stats.displays);
+    if(lcd->async_enabled)
+    {
+        __submit(lcd, 1);
+        return;
+    }
+    STATS(__statsbegin(lcd, NULL));
+    __sendall(lcd, lcd->buffer);
+    __flush(lcd);
+    STATS(__statsend(lcd));
+    __cleardirty(lcd->dirty);
+}
+
+/** \brief Takes a snapshot of the display counters
+ *
+ * The counters are only kept when the library is built with PCD8544_STATS
+ * (make STATS=1); otherwise nothing is counted and this fails. The snapshot
+ * is consistent with the flush thread, but should be taken from the thread
+ * that draws.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[out] s pcd8544_stats_t* Snapshot
+ * \return int 0 on success, -1 when built without PCD8544_STATS
+ *
+ */
+
+int pcd8544_getStats(pcd8544_t *lcd, pcd8544_stats_t *s)
+{
+#ifdef PCD8544_STATS
+    __buslock(lcd);
+    *s = lcd->stats;
+    __busunlock(lcd);
+    return 0;
+#else
+    (void)lcd;
+    memset(s, 0, sizeof(pcd8544_stats_t));
+    return -1;
+#endif
+}
+
+/** \brief Resets the display counters
+ *
+ * \param[in] lcd pcd8544_t* Display handle
  *
  */
 
-void LCDclear(void)
+void pcd8544_resetStats(pcd8544_t *lcd)
 {
-    memset(pcd8544_buffer, 0, LCDWIDTH*LCDHEIGHT/8);
-    LCDsetPosition(0, 0);
-    LCDdataArray(pcd8544_buffer, LCDWIDTH*LCDHEIGHT/8);
-    LCDsetPosition(0, 0);
-    xUpdateMin = (LCDWIDTH-1);
-    xUpdateMax = 0;
-    yUpdateMin = (LCDHEIGHT-1);
-    yUpdateMax = 0;
+#ifdef PCD8544_STATS
+    __buslock(lcd);
+    memset(&lcd->stats, 0, sizeof(pcd8544_stats_t));
+    __busunlock(lcd);
+#else
+    (void)lcd;
+#endif
 }
 
 /** \brief Delays for milliseconds
@@ -0,0 +1,751 @@
+/**
+ * @file PCD8544_default.c
+ * @brief This file contains the default display instance and the LCD* API bound to it.
+ * @author Sk. Mohammadul Haque, Andre Wussow, Limor Fried (originally)
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque (this version)
+ * Copyright (c) 2012 Andre Wussow (Raspberry Pi version)
+ * Copyright (c) 2010 Limor Fried, Adafruit Industries
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#include <pthread.h>
+#include "../include/PCD8544.h"
+#include "PCD8544_private.h"
+
+uint8_t pcd8544_buffer[LCDWIDTH*LCDHEIGHT/8] = {0,}; /**< PCD8544 drawing buffer (default display) */
+
+/** \cond HIDDEN_SYMBOLS */
+
+static pcd8544_t default_lcd =
+{
+    .buffer = pcd8544_buffer,
+    .screen = {pcd8544_buffer, LCDWIDTH, LCDHEIGHT, LCDWIDTH},
+    .textsize = 1,
+    .textcolor = BLACK,
+    .textfont = &pcd8544_font5x8,
+    .dc = 0xFF,
+    .flush_lock = PTHREAD_MUTEX_INITIALIZER,
+    .bus_lock = PTHREAD_MUTEX_INITIALIZER,
+    .flush_cond = PTHREAD_COND_INITIALIZER,
+    .idle_cond = PTHREAD_COND_INITIALIZER,
+    .back_buffer = default_lcd.async_buffers[0],
+    .send_buffer = default_lcd.async_buffers[1],
+};
+
+/** \endcond */
+
+/** \brief Returns the default display instance used by the LCD* functions
+ *
+ * \return pcd8544_t* Display handle
+ *
+ */
+
+pcd8544_t *pcd8544_default()
+{
+    return &default_lcd;
+}
+
+/** \brief Initializes the LCD Module (default display)
+ *
+ * \param[in] SCLK uint8_t Clock
+ * \param[in] DIN uint8_t Data in
+ * \param[in] DC uint8_t Data/Command
+ * \param[in] CS uint8_t Chip Select
+ * \param[in] RST uint8_t Reset
+ * \param[in] contrast uint8_t LCD contrast value (0-127)
+ * \param[in] spi_enabled uint8_t Enable SPI (0/1)
+ *
+ */
+
+void LCDInit(uint8_t SCLK, uint8_t DIN, uint8_t DC, uint8_t CS, uint8_t RST, uint8_t contrast, uint8_t spi_enabled)
+{
+    pcd8544_init(&default_lcd, SCLK, DIN, DC, CS, RST, contrast, spi_enabled);
+}
+
+/** \brief Initializes the LCD Module over a given transport backend (default display)
+ *
+ * \param[in] t pcd8544_transport_t* Transport backend (copied)
+ * \param[in] contrast uint8_t LCD contrast value (0-127)
+ *
+ */
+
+void LCDInitTransport(const pcd8544_transport_t *t, uint8_t contrast)
+{
+    pcd8544_inittransport(&default_lcd, t, contrast);
+}
+
+/** \brief Sets LCD power mode (default display)
+ *
+ * \param mode uint8_t LCD power mode (LCD_ON/LCD_OFF)
+ *
+ */
+
+void LCDsetPower(uint8_t mode)
+{
+    pcd8544_setPower(&default_lcd, mode);
+}
+
+/** \brief Displays the Raspberry Pi logo (default display)
+ *
+ *
+ */
+
+void LCDshowLogo()
+{
+    pcd8544_showLogo(&default_lcd);
+}
+
+/** \brief Draws a bitmap with WHITE/BLACK (default display)
+ *
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] bitmap uint8_t* Raw bitmap
+ * \param[in] w uint8_t Bitmap width
+ * \param[in] h uint8_t Bitmap height
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDdrawbitmap(uint8_t x, uint8_t y,const uint8_t *bitmap, uint8_t w, uint8_t h,uint8_t color)
+{
+    pcd8544_drawbitmap(&default_lcd, x, y, bitmap, w, h, color);
+}
+
+/** \brief Blits a bitmap with a raster operation and clipping (default display)
+ *
+ * \param[in] x int16_t Horizontal position (may be off-screen)
+ * \param[in] y int16_t Vertical position (may be off-screen)
+ * \param[in] bitmap uint8_t* Raw bitmap
+ * \param[in] w uint8_t Bitmap width
+ * \param[in] h uint8_t Bitmap height
+ * \param[in] rop uint8_t Raster operation (LCD_ROP_COPY/LCD_ROP_OR/LCD_ROP_AND/LCD_ROP_ANDNOT/LCD_ROP_XOR/LCD_ROP_INVERT)
+ *
+ */
+
+void LCDblitbitmap(int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t rop)
+{
+    pcd8544_blitbitmap(&default_lcd, x, y, bitmap, w, h, rop);
+}
+
+/** \brief Draws a full bit-frame (default display)
+ *
+ * \param[in] bitframe uint8_t* Raw bit-frame
+ * \param[in] type uint8_t Positive/ Negative (LCD_POS/LCD_NEG)
+ *
+ */
+
+void LCDdrawbitframe(const uint8_t *bitframe, uint8_t type)
+{
+    pcd8544_drawbitframe(&default_lcd, bitframe, type);
+}
+
+/** \brief Feeds a chunk of a compressed frame into the drawing buffer (default display)
+ *
+ * \param[in,out] d pcd8544_rle_t* Decoder state (see LCDframeBegin)
+ * \param[in] data uint8_t* Compressed bytes
+ * \param[in] n uint16_t Number of bytes
+ * \return int Number of bytes consumed, -1 if the data is corrupt
+ *
+ */
+
+int LCDfeedFrame(pcd8544_rle_t *d, const uint8_t *data, uint16_t n)
+{
+    return pcd8544_feedFrame(&default_lcd, d, data, n);
+}
+
+/** \brief Draws a complete compressed frame (default display)
+ *
+ * \param[in] data uint8_t* Compressed frame (see LCDencodeFrame)
+ * \param[in] n uint16_t Size of the compressed frame
+ * \return int 0 on success, -1 if the data is corrupt or incomplete
+ *
+ */
+
+int LCDdrawframe(const uint8_t *data, uint16_t n)
+{
+    return pcd8544_drawframe(&default_lcd, data, n);
+}
+
+/** \brief Prints a string (default display)
+ *
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] c char* String to be printed
+ *
+ */
+
+void LCDdrawstring(uint8_t x, uint8_t y, char *c)
+{
+    pcd8544_drawstring(&default_lcd, x, y, c);
+}
+
+/** \brief Prints a character (default display)
+ *
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] c char Character to be printed
+ *
+ */
+
+void LCDdrawchar(uint8_t x, uint8_t y, char c)
+{
+    pcd8544_drawchar(&default_lcd, x, y, c);
+}
+
+/** \brief Prints a character at current position (default display)
+ *
+ * \param[in] c uint8_t Character to be printed
+ *
+ */
+
+void LCDwrite(uint8_t c)
+{
+    pcd8544_write(&default_lcd, c);
+}
+
+/** \brief Set LCD display mode (default display)
+ *
+ * \param mode uint8_t Display mode (PCD8544_DISPLAYBLANK/PCD8544_DISPLAYNORMAL/PCD8544_DISPLAYALLON/PCD8544_DISPLAYINVERTED)
+ *
+ */
+
+void LCDsetDisplayMode(uint8_t mode)
+{
+    pcd8544_setDisplayMode(&default_lcd, mode);
+}
+
+/** \brief Sets the LCD contrast (default display)
+ *
+ * \param[in] val uint8_t Contrast value (0-127)
+ *
+ */
+
+void LCDsetContrast(uint8_t val)
+{
+    pcd8544_setContrast(&default_lcd, val);
+}
+
+/** \brief Sets cursor position (default display)
+ *
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ *
+ */
+
+void LCDsetCursor(uint8_t x, uint8_t y)
+{
+    pcd8544_setCursor(&default_lcd, x, y);
+}
+
+/** \brief Sets current position on LCD (default display)
+ *
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ *
+ */
+
+void LCDsetPosition(uint8_t x, uint8_t y)
+{
+    pcd8544_setPosition(&default_lcd, x, y);
+}
+
+/** \brief Sets text size (default display)
+ *
+ * \param s uint8_t Text size (1-4)
+ *
+ */
+
+void LCDsetTextSize(uint8_t s)
+{
+    pcd8544_setTextSize(&default_lcd, s);
+}
+
+/** \brief Sets text color (default display)
+ *
+ * \param c uint8_t Text color (WHITE/BLACK)
+ *
+ */
+
+void LCDsetTextColor(uint8_t c)
+{
+    pcd8544_setTextColor(&default_lcd, c);
+}
+
+/** \brief Sets the font used for text (default display)
+ *
+ * \param f pcd8544_font_t* Font (NULL - built-in 5x8 font)
+ *
+ */
+
+void LCDsetFont(const pcd8544_font_t *f)
+{
+    pcd8544_setFont(&default_lcd, f);
+}
+
+/** \brief Measures the width of a string (default display)
+ *
+ * \param[in] c char* String to be measured
+ * \return uint16_t Advance width of the longest line in pixels
+ *
+ */
+
+uint16_t LCDstringWidth(const char *c)
+{
+    return pcd8544_stringWidth(&default_lcd, c);
+}
+
+/** \brief Measures the height of a string (default display)
+ *
+ * \param[in] c char* String to be measured
+ * \return uint16_t Height of all lines in pixels
+ *
+ */
+
+uint16_t LCDstringHeight(const char *c)
+{
+    return pcd8544_stringHeight(&default_lcd, c);
+}
+
+/** \brief Sets a pixel with color (default display)
+ *
+ * \param[in] x uint8_t horizontal position
+ * \param[in] y uint8_t vertical position
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDsetPixel(uint8_t x, uint8_t y, uint8_t color)
+{
+    pcd8544_setPixel(&default_lcd, x, y, color);
+}
+
+/** \brief Gets a pixel's value (default display)
+ *
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \return uint8_t Pixel value
+ *
+ */
+
+uint8_t LCDgetPixel(uint8_t x, uint8_t y)
+{
+    return pcd8544_getPixel(&default_lcd, x, y);
+}
+
+/** \brief Saves the drawing buffer as a binary PBM image (default display)
+ *
+ * \param[in] path char* File name
+ * \return int 0 on success, -1 on failure
+ *
+ */
+
+int LCDsavePBM(const char *path)
+{
+    return pcd8544_savePBM(&default_lcd, path);
+}
+
+/** \brief Compares the drawing buffer with a PBM image (default display)
+ *
+ * \param[in] path char* File name
+ * \return int Number of differing pixels, -1 if the image cannot be read or has the wrong size
+ *
+ */
+
+int LCDcomparePBM(const char *path)
+{
+    return pcd8544_comparePBM(&default_lcd, path);
+}
+
+/** \brief Takes a snapshot of the display counters (default display)
+ *
+ * \param[out] s pcd8544_stats_t* Snapshot
+ * \return int 0 on success, -1 when built without PCD8544_STATS
+ *
+ */
+
+int LCDgetStats(pcd8544_stats_t *s)
+{
+    return pcd8544_getStats(&default_lcd, s);
+}
+
+/** \brief Resets the display counters (default display)
+ *
+ *
+ */
+
+void LCDresetStats()
+{
+    pcd8544_resetStats(&default_lcd);
+}
+
+/** \brief Draws a line (default display)
+ *
+ * \param[in] x0 uint8_t Horizontal start position
+ * \param[in] y0 uint8_t Vertical start position
+ * \param[in] x1 uint8_t Horizontal end position
+ * \param[in] y1 uint8_t Vertical end position
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDdrawline(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color)
+{
+    pcd8544_drawline(&default_lcd, x0, y0, x1, y1, color);
+}
+
+/** \brief Draws a rectangle (default display)
+ *
+ * \param[in] x uint8_t Horizontal start position
+ * \param[in] y uint8_t Vertical start position
+ * \param[in] w uint8_t Width
+ * \param[in] h uint8_t Height
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDdrawrect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color)
+{
+    pcd8544_drawrect(&default_lcd, x, y, w, h, color);
+}
+
+/** \brief Draws a filled rectangle (default display)
+ *
+ * \param[in] x uint8_t Horizontal start position
+ * \param[in] y uint8_t Vertical start position
+ * \param[in] w uint8_t Width
+ * \param[in] h uint8_t Height
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDfillrect(uint8_t x, uint8_t y, uint8_t w, uint8_t h,  uint8_t color)
+{
+    pcd8544_fillrect(&default_lcd, x, y, w, h, color);
+}
+
+/** \brief Draws a horizontal line (default display)
+ *
+ * \param[in] x uint8_t Horizontal start position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] w uint8_t Width
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDdrawhline(uint8_t x, uint8_t y, uint8_t w, uint8_t color)
+{
+    pcd8544_drawhline(&default_lcd, x, y, w, color);
+}
+
+/** \brief Draws a vertical line (default display)
+ *
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical start position
+ * \param[in] h uint8_t Height
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDdrawvline(uint8_t x, uint8_t y, uint8_t h, uint8_t color)
+{
+    pcd8544_drawvline(&default_lcd, x, y, h, color);
+}
+
+/** \brief Draws a circle (default display)
+ *
+ * \param[in] x0 uint8_t Horizontal position
+ * \param[in] y0 uint8_t Vertical position
+ * \param[in] r uint8_t Radius
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDdrawcircle(uint8_t x0, uint8_t y0, uint8_t r, uint8_t color)
+{
+    pcd8544_drawcircle(&default_lcd, x0, y0, r, color);
+}
+
+/** \brief Draws a filled circle (default display)
+ *
+ * \param[in] x0 uint8_t Horizontal position
+ * \param[in] y0 uint8_t Vertical position
+ * \param[in] r uint8_t Radius
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDfillcircle(uint8_t x0, uint8_t y0, uint8_t r, uint8_t color)
+{
+    pcd8544_fillcircle(&default_lcd, x0, y0, r, color);
+}
+
+/** \brief Draws a filled triangle (default display)
+ *
+ * \param[in] x0 int16_t First vertex horizontal position
+ * \param[in] y0 int16_t First vertex vertical position
+ * \param[in] x1 int16_t Second vertex horizontal position
+ * \param[in] y1 int16_t Second vertex vertical position
+ * \param[in] x2 int16_t Third vertex horizontal position
+ * \param[in] y2 int16_t Third vertex vertical position
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDfilltriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint8_t color)
+{
+    pcd8544_filltriangle(&default_lcd, x0, y0, x1, y1, x2, y2, color);
+}
+
+/** \brief Draws a filled polygon (default display)
+ *
+ * \param[in] xy int16_t* Vertices as x, y pairs
+ * \param[in] n uint8_t Number of vertices
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDfillpolygon(const int16_t *xy, uint8_t n, uint8_t color)
+{
+    pcd8544_fillpolygon(&default_lcd, xy, n, color);
+}
+
+/** \brief Draws a filled rectangle with rounded corners (default display)
+ *
+ * \param[in] x uint8_t Horizontal start position
+ * \param[in] y uint8_t Vertical start position
+ * \param[in] w uint8_t Width
+ * \param[in] h uint8_t Height
+ * \param[in] r uint8_t Corner radius
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDfillroundrect(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t r, uint8_t color)
+{
+    pcd8544_fillroundrect(&default_lcd, x, y, w, h, r, color);
+}
+
+/** \brief Draws a filled ellipse (default display)
+ *
+ * \param[in] x0 uint8_t Horizontal position
+ * \param[in] y0 uint8_t Vertical position
+ * \param[in] rx uint8_t Horizontal radius
+ * \param[in] ry uint8_t Vertical radius
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDfillellipse(uint8_t x0, uint8_t y0, uint8_t rx, uint8_t ry, uint8_t color)
+{
+    pcd8544_fillellipse(&default_lcd, x0, y0, rx, ry, color);
+}
+
+/** \brief Returns the drawing buffer as a canvas (default display)
+ *
+ * \param[out] c pcd8544_canvas_t* Canvas
+ *
+ */
+
+void LCDgetcanvas(pcd8544_canvas_t *c)
+{
+    pcd8544_getcanvas(&default_lcd, c);
+}
+
+/** \brief Marks a block of the drawing buffer as changed (default display)
+ *
+ * \param[in] x int16_t Horizontal position (may be off-screen)
+ * \param[in] y int16_t Vertical position (may be off-screen)
+ * \param[in] w uint16_t Width
+ * \param[in] h uint16_t Height
+ *
+ */
+
+void LCDinvalidate(int16_t x, int16_t y, uint16_t w, uint16_t h)
+{
+    pcd8544_invalidate(&default_lcd, x, y, w, h);
+}
+
+/** \brief Blits part of a canvas onto the display with a raster operation (default display)
+ *
+ * \param[in] x int16_t Horizontal position (may be off-screen)
+ * \param[in] y int16_t Vertical position (may be off-screen)
+ * \param[in] src pcd8544_canvas_t* Source canvas
+ * \param[in] sx int16_t Horizontal position in the source
+ * \param[in] sy int16_t Vertical position in the source
+ * \param[in] w uint16_t Width
+ * \param[in] h uint16_t Height
+ * \param[in] rop uint8_t Raster operation (LCD_ROP_COPY/LCD_ROP_OR/LCD_ROP_AND/LCD_ROP_ANDNOT/LCD_ROP_XOR/LCD_ROP_INVERT)
+ *
+ */
+
+void LCDblitcanvas(int16_t x, int16_t y, const pcd8544_canvas_t *src, int16_t sx, int16_t sy, uint16_t w, uint16_t h, uint8_t rop)
+{
+    pcd8544_blitcanvas(&default_lcd, x, y, src, sx, sy, w, h, rop);
+}
+
+/** \brief Writes out a byte (default display)
+ *
+ * \param[in] c uint8_t Byte
+ *
+ */
+
+void LCDspiwrite(uint8_t c)
+{
+    pcd8544_spiwrite(&default_lcd, c);
+}
+
+/** \brief Writes out an array (default display)
+ *
+ * \param[in] c uint8_t* Array
+ * \param[in] n uint16_t Size of array
+ *
+ */
+
+void LCDspiwriteArray(uint8_t *c, uint16_t n)
+{
+    pcd8544_spiwriteArray(&default_lcd, c, n);
+}
+
+/** \brief Writes out a command byte (default display)
+ *
+ * \param[in] c uint8_t Command
+ *
+ */
+
+void LCDcommand(uint8_t c)
+{
+    pcd8544_command(&default_lcd, c);
+}
+
+/** \brief Writes out a command array (default display)
+ *
+ * \param[in] c uint8_t* Command array
+ * \param[in] n uint16_t Size of array
+ *
+ */
+
+void LCDcommandArray(uint8_t *c, uint16_t n)
+{
+    pcd8544_commandArray(&default_lcd, c, n);
+}
+
+/** \brief Writes out a data byte (default display)
+ *
+ * \param[in] c uint8_t Data
+ *
+ */
+
+void LCDdata(uint8_t c)
+{
+    pcd8544_data(&default_lcd, c);
+}
+
+/** \brief Writes out a data array (default display)
+ *
+ * \param[in] c uint8_t* Data array
+ * \param[in] n uint16_t Size of array
+ *
+ */
+
+void LCDdataArray(uint8_t *c, uint16_t n)
+{
+    pcd8544_dataArray(&default_lcd, c, n);
+}
+
+/** \brief Sets the shadow-framebuffer diff mode (default display)
+ *
+ * \param[in] mode uint8_t Diff mode (LCD_ON/LCD_OFF)
+ *
+ */
+
+void LCDsetDiffMode(uint8_t mode)
+{
+    pcd8544_setDiffMode(&default_lcd, mode);
+}
+
+/** \brief Sets the asynchronous flush mode (default display)
+ *
+ * \param[in] mode uint8_t Async mode (LCD_ON/LCD_OFF)
+ *
+ */
+
+void LCDsetAsync(uint8_t mode)
+{
+    pcd8544_setAsync(&default_lcd, mode);
+}
+
+/** \brief Waits until all submitted frames have been sent (default display)
+ *
+ *
+ */
+
+void LCDwaitFlush()
+{
+    pcd8544_waitFlush(&default_lcd);
+}
+
+/** \brief Caps the asynchronous flush rate (default display)
+ *
+ * \param[in] fps uint16_t Maximum frames per second (0 - unlimited)
+ *
+ */
+
+void LCDsetFrameRateCap(uint16_t fps)
+{
+    pcd8544_setFrameRateCap(&default_lcd, fps);
+}
+
+/** \brief Resets the drawing buffer (default display)
+ *
+ *
+ */
+
+void LCDzero()
+{
+    pcd8544_zero(&default_lcd);
+}
+
+/** \brief Displays the drawing buffer (default display)
+ *
+ *
+ */
+
+void LCDdisplay()
+{
+    pcd8544_display(&default_lcd);
+}
+
+/** \brief Updates the LCD (default display)
+ *
+ *
+ */
+
+void LCDupdate()
+{
+    pcd8544_update(&default_lcd);
+}
+
+/** \brief Clears the LCD (default display)
+ *
+ *
+ */
+
+void LCDclear()
+{
+    pcd8544_clear(&default_lcd);
+}
@@ -0,0 +1,372 @@
+/**
+ * @file PCD8544_dither.c
+ * @brief This file contains grayscale and colour image import for PCD8544 display.
+ * @author Sk. Mohammadul Haque, Andre Wussow, Limor Fried (originally)
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque (this version)
+ * Copyright (c) 2012 Andre Wussow (Raspberry Pi version)
+ * Copyright (c) 2010 Limor Fried, Adafruit Industries
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/PCD8544.h"
+
+#ifndef PCD8544_NO_SIMD
+#if defined(__ARM_NEON)||defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DITHER_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DITHER_SSE2
+#endif
+#endif
+
+/** \cond HIDDEN_SYMBOLS */
+
+/* 8x8 ordered dither matrix, scaled to thresholds 2..254 by __thresholds */
+static const uint8_t bayer8[8][8] =
+{
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21}
+};
+
+/* first source row or column of destination step i out of n over a source of size s */
+static uint16_t __srcstart(uint16_t i, uint16_t n, uint16_t s)
+{
+    return (uint16_t)((uint32_t)i*s/n);
+}
+
+static uint16_t __srcend(uint16_t i, uint16_t n, uint16_t s)
+{
+    uint16_t a = __srcstart(i, n, s), b = __srcstart(i+1, n, s);
+    return (b>a)?b:(a+1);
+}
+
+/* on[i] = 0xff where gray[i] is darker than thr[i], else 0 */
+static void __threshold(uint8_t *on, const uint8_t *gray, const uint8_t *thr, uint16_t n)
+{
+    uint16_t i = 0;
+#if defined(DITHER_NEON)
+    for(; i+16<=n; i+=16) vst1q_u8(on+i, vcltq_u8(vld1q_u8(gray+i), vld1q_u8(thr+i)));
+#elif defined(DITHER_SSE2)
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    for(; i+16<=n; i+=16)
+    {
+        __m128i g = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(gray+i)), bias);
+        __m128i t = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(thr+i)), bias);
+        _mm_storeu_si128((__m128i *)(on+i), _mm_cmplt_epi8(g, t));
+    }
+#endif
+    for(; i<n; ++i) on[i] = (gray[i]<thr[i])?0xff:0x00;
+}
+
+/* copies the bits m of on[] into n page bytes */
+static void __pack(uint8_t *p, const uint8_t *on, uint8_t m, uint16_t n)
+{
+    uint16_t i = 0;
+#if defined(DITHER_NEON)
+    const uint8x16_t sel = vdupq_n_u8(m);
+    for(; i+16<=n; i+=16) vst1q_u8(p+i, vbslq_u8(sel, vld1q_u8(on+i), vld1q_u8(p+i)));
+#elif defined(DITHER_SSE2)
+    const __m128i sel = _mm_set1_epi8((char)m);
+    for(; i+16<=n; i+=16)
+    {
+        __m128i o = _mm_and_si128(sel, _mm_loadu_si128((const __m128i *)(on+i)));
+        __m128i d = _mm_andnot_si128(sel, _mm_loadu_si128((const __m128i *)(p+i)));
+        _mm_storeu_si128((__m128i *)(p+i), _mm_or_si128(o, d));
+    }
+#endif
+    for(; i<n; ++i) p[i] = (uint8_t)((p[i]&~m)|(on[i]&m));
+}
+
+/* ordered thresholds of destination row y, tiled from the canvas origin */
+static void __thresholds(const pcd8544_dither_t *d, uint8_t *thr, int16_t y)
+{
+    uint8_t pattern[8], i;
+    if(d->method!=LCD_DITHER_BAYER)
+    {
+        memset(thr, 128, d->w);
+        return;
+    }
+    for(i=0; i<8; ++i) pattern[i] = (uint8_t)(bayer8[y&7][(d->x+i)&7]*4+2);
+    for(i=0; i<d->w; ++i) thr[i] = pattern[i&7];
+}
+
+/* error diffusion of one row, the errors of the next rows are gathered in d->err */
+static void __diffuse(pcd8544_dither_t *d, uint8_t *on, const uint8_t *gray)
+{
+    int16_t *e0 = d->err[d->cur]+2, *e1 = d->err[(d->cur+1)%3]+2, *e2 = d->err[(d->cur+2)%3]+2, v, q;
+    uint8_t i;
+    for(i=0; i<d->w; ++i)
+    {
+        v = gray[i]+e0[i];
+        on[i] = (v<128)?0xff:0x00;
+        q = on[i]?v:(v-255);
+        if(d->method==LCD_DITHER_FLOYD)
+        {
+            e0[i+1] += q*7/16;
+            e1[i-1] += q*3/16;
+            e1[i] += q*5/16;
+            e1[i+1] += q/16;
+        }
+        else
+        {
+            q /= 8;
+            e0[i+1] += q;
+            e0[i+2] += q;
+            e1[i-1] += q;
+            e1[i] += q;
+            e1[i+1] += q;
+            e2[i] += q;
+        }
+    }
+    memset(d->err[d->cur], 0, sizeof(d->err[0]));
+    d->cur = (d->cur+1)%3;
+}
+
+/* averages the source pixels gathered in d->sum for destination row d->line */
+static void __average(const pcd8544_dither_t *d, uint8_t *gray)
+{
+    uint16_t rows = __srcend(d->line, d->h, d->srch)-__srcstart(d->line, d->h, d->srch);
+    uint32_t n;
+    uint8_t i;
+    for(i=0; i<d->w; ++i)
+    {
+        n = (uint32_t)(d->xend[i]-d->xstart[i])*rows;
+        gray[i] = (uint8_t)((d->sum[i]+n/2)/n);
+    }
+}
+
+/* dithers destination row d->line into the canvas */
+static void __emit(pcd8544_dither_t *d, const uint8_t *gray)
+{
+    uint8_t thr[LCDWIDTH], on[LCDWIDTH];
+    int16_t y = d->y+d->line, x0 = d->x, x1 = d->x+d->w;
+    if((d->method==LCD_DITHER_FLOYD)||(d->method==LCD_DITHER_ATKINSON)) __diffuse(d, on, gray);
+    else
+    {
+        __thresholds(d, thr, y);
+        __threshold(on, gray, thr, d->w);
+    }
+    ++d->line;
+    if(x0<0) x0 = 0;
+    if(x1>d->canvas.width) x1 = d->canvas.width;
+    if((y<0)||(y>=d->canvas.height)||(x0>=x1)) return;
+    __pack(d->canvas.buffer+x0+(y>>3)*d->canvas.stride, on+(x0-d->x), (uint8_t)(1<<(y&7)), x1-x0);
+}
+
+/** \endcond */
+
+/** \brief Starts importing an image into a rect of a canvas
+ *
+ * The source is fed one row at a time with LCDditherRow, so no copy of
+ * it is kept. It is scaled to w x h by averaging the source pixels that
+ * fall on each destination pixel (or repeating them when enlarging),
+ * then dithered to black and white and written straight into the
+ * canvas bytes. Parts of the rect off the canvas are dropped. Ordered
+ * patterns are aligned to the canvas, so neighbouring imports tile.
+ * A canvas of the panel size gives a frame for LCDdrawbitframe; the
+ * display's own canvas (see pcd8544_getcanvas) draws on screen, after
+ * which the rect has to be passed to pcd8544_invalidate.
+ *
+ * \param[out] d pcd8544_dither_t* Import state
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal position of the rect
+ * \param[in] y int16_t Vertical position of the rect
+ * \param[in] w uint8_t Width of the rect (at most LCDWIDTH, 0 - canvas width)
+ * \param[in] h uint8_t Height of the rect (0 - canvas height)
+ * \param[in] srcw uint16_t Source width
+ * \param[in] srch uint16_t Source height
+ * \param[in] format uint8_t LCD_DITHER_GRAY/LCD_DITHER_RGB
+ * \param[in] method uint8_t LCD_DITHER_THRESHOLD/LCD_DITHER_BAYER/LCD_DITHER_FLOYD/LCD_DITHER_ATKINSON
+ * \return int 0 on success, -1 on invalid arguments
+ *
+ */
+
+int LCDditherBegin(pcd8544_dither_t *d, const pcd8544_canvas_t *c, int16_t x, int16_t y, uint8_t w, uint8_t h, uint16_t srcw, uint16_t srch, uint8_t format, uint8_t method)
+{
+    uint8_t i;
+    if(!w) w = (c->width>LCDWIDTH)?LCDWIDTH:(uint8_t)c->width;
+    if(!h) h = (c->height>255)?255:(uint8_t)c->height;
+    if((w>LCDWIDTH)||!w||!h||!srcw||!srch||(format>LCD_DITHER_RGB)||(method>LCD_DITHER_ATKINSON))
+    {
+        printf("Invalid image import.\n");
+        return -1;
+    }
+    if((uint64_t)(srcw/w+1)*(srch/h+1)*255>UINT32_MAX)
+    {
+        printf("Image too large for a %dx%d rect.\n", w, h);
+        return -1;
+    }
+    memset(d, 0, sizeof(pcd8544_dither_t));
+    d->canvas = *c;
+    d->x = x;
+    d->y = y;
+    d->w = w;
+    d->h = h;
+    d->srcw = srcw;
+    d->srch = srch;
+    d->format = format;
+    d->method = method;
+    for(i=0; i<w; ++i)
+    {
+        d->xstart[i] = __srcstart(i, w, srcw);
+        d->xend[i] = __srcend(i, w, srcw);
+    }
+    return 0;
+}
+
+/** \brief Feeds the next source row of an image import
+ *
+ * \param[in,out] d pcd8544_dither_t* Import state
+ * \param[in] row uint8_t* Source row, srcw gray bytes or srcw R, G, B triples
+ * \return int Number of destination rows completed, -1 once all source rows were fed
+ *
+ */
+
+int LCDditherRow(pcd8544_dither_t *d, const uint8_t *row)
+{
+    uint32_t hsum[LCDWIDTH], s;
+    uint16_t j, e, r = d->row;
+    uint8_t gray[LCDWIDTH], k, w = d->w;
+    int n = 0;
+    if(r>=d->srch) return -1;
+    ++d->row;
+    if((d->srcw==w)&&(d->srch==d->h))
+    {
+        /* same size, nothing to average */
+        if(d->format==LCD_DITHER_GRAY)
+        {
+            __emit(d, row);
+            return 1;
+        }
+        for(k=0; k<w; ++k, row+=3) gray[k] = (77*row[0]+150*row[1]+29*row[2]+128)>>8;
+        __emit(d, gray);
+        return 1;
+    }
+    for(k=0; k<w; ++k)
+    {
+        e = d->xend[k];
+        s = 0;
+        if(d->format==LCD_DITHER_RGB)
+        {
+            for(j=d->xstart[k]; j<e; ++j) s += (77*row[3*j]+150*row[3*j+1]+29*row[3*j+2]+128)>>8;
+        }
+        else
+        {
+            for(j=d->xstart[k]; j<e; ++j) s += row[j];
+        }
+        hsum[k] = s;
+        d->sum[k] += s;
+    }
+    while((d->line<d->h)&&(__srcend(d->line, d->h, d->srch)==d->row))
+    {
+        __average(d, gray);
+        __emit(d, gray);
+        ++n;
+        /* when enlarging, the next row starts over from this source row */
+        if((d->line<d->h)&&(__srcstart(d->line, d->h, d->srch)==r)) memcpy(d->sum, hsum, sizeof(uint32_t)*w);
+        else memset(d->sum, 0, sizeof(uint32_t)*w);
+    }
+    return n;
+}
+
+/** \brief Imports a whole image into a rect of a canvas
+ *
+ * \param[in] c pcd8544_canvas_t* Canvas
+ * \param[in] x int16_t Horizontal position of the rect
+ * \param[in] y int16_t Vertical position of the rect
+ * \param[in] w uint8_t Width of the rect (at most LCDWIDTH, 0 - canvas width)
+ * \param[in] h uint8_t Height of the rect (0 - canvas height)
+ * \param[in] src uint8_t* Source pixels
+ * \param[in] srcw uint16_t Source width
+ * \param[in] srch uint16_t Source height
+ * \param[in] srcstride uint32_t Bytes from one source row to the next (0 - packed rows)
+ * \param[in] format uint8_t LCD_DITHER_GRAY/LCD_DITHER_RGB
+ * \param[in] method uint8_t LCD_DITHER_THRESHOLD/LCD_DITHER_BAYER/LCD_DITHER_FLOYD/LCD_DITHER_ATKINSON
+ * \return int 0 on success, -1 on invalid arguments
+ *
+ */
+
+int LCDcanvasDrawimage(const pcd8544_canvas_t *c, int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *src, uint16_t srcw, uint16_t srch, uint32_t srcstride, uint8_t format, uint8_t method)
+{
+    pcd8544_dither_t d;
+    uint16_t i;
+    if(LCDditherBegin(&d, c, x, y, w, h, srcw, srch, format, method)<0) return -1;
+    if(!srcstride) srcstride = (uint32_t)srcw*((format==LCD_DITHER_RGB)?3:1);
+    for(i=0; i<srch; ++i) LCDditherRow(&d, src+(size_t)i*srcstride);
+    return 0;
+}
+
+/** \brief Imports a whole image into a rect of the display
+ *
+ * See LCDditherBegin for the scaling and dithering.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] x int16_t Horizontal position of the rect
+ * \param[in] y int16_t Vertical position of the rect
+ * \param[in] w uint8_t Width of the rect (0 - LCDWIDTH)
+ * \param[in] h uint8_t Height of the rect (0 - LCDHEIGHT)
+ * \param[in] src uint8_t* Source pixels
+ * \param[in] srcw uint16_t Source width
+ * \param[in] srch uint16_t Source height
+ * \param[in] srcstride uint32_t Bytes from one source row to the next (0 - packed rows)
+ * \param[in] format uint8_t LCD_DITHER_GRAY/LCD_DITHER_RGB
+ * \param[in] method uint8_t LCD_DITHER_THRESHOLD/LCD_DITHER_BAYER/LCD_DITHER_FLOYD/LCD_DITHER_ATKINSON
+ * \return int 0 on success, -1 on invalid arguments
+ *
+ */
+
+int pcd8544_drawimage(pcd8544_t *lcd, int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *src, uint16_t srcw, uint16_t srch, uint32_t srcstride, uint8_t format, uint8_t method)
+{
+    pcd8544_canvas_t c;
+    pcd8544_getcanvas(lcd, &c);
+    if(!w) w = LCDWIDTH;
+    if(!h) h = LCDHEIGHT;
+    if(LCDcanvasDrawimage(&c, x, y, w, h, src, srcw, srch, srcstride, format, method)<0) return -1;
+    pcd8544_invalidate(lcd, x, y, w, h);
+    return 0;
+}
+
+/** \brief Imports a whole image into a rect of the display (default display)
+ *
+ * \param[in] x int16_t Horizontal position of the rect
+ * \param[in] y int16_t Vertical position of the rect
+ * \param[in] w uint8_t Width of the rect (0 - LCDWIDTH)
+ * \param[in] h uint8_t Height of the rect (0 - LCDHEIGHT)
+ * \param[in] src uint8_t* Source pixels
+ * \param[in] srcw uint16_t Source width
+ * \param[in] srch uint16_t Source height
+ * \param[in] srcstride uint32_t Bytes from one source row to the next (0 - packed rows)
+ * \param[in] format uint8_t LCD_DITHER_GRAY/LCD_DITHER_RGB
+ * \param[in] method uint8_t LCD_DITHER_THRESHOLD/LCD_DITHER_BAYER/LCD_DITHER_FLOYD/LCD_DITHER_ATKINSON
+ * \return int 0 on success, -1 on invalid arguments
+ *
+ */
+
+int LCDdrawimage(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t *src, uint16_t srcw, uint16_t srch, uint32_t srcstride, uint8_t format, uint8_t method)
+{
+    return pcd8544_drawimage(pcd8544_default(), x, y, w, h, src, srcw, srch, srcstride, format, method);
+}
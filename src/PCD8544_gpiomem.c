@@ -0,0 +1,281 @@
+/**
+ * @file PCD8544_gpiomem.c
+ * @brief This file contains the register-level GPIO bit-banging backend for PCD8544 display.
+ * @author Sk. Mohammadul Haque, Andre Wussow, Limor Fried (originally)
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque (this version)
+ * Copyright (c) 2012 Andre Wussow (Raspberry Pi version)
+ * Copyright (c) 2010 Limor Fried, Adafruit Industries
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/PCD8544.h"
+
+/** \cond HIDDEN_SYMBOLS */
+
+#define GPIO_MAPSIZE 4096
+#define GPIO_GPFSEL0 (0x00/4)
+#define GPIO_GPSET0 (0x1C/4)
+#define GPIO_GPCLR0 (0x28/4)
+#define GPIO_MAX_HZ 4000000 /* PCD8544 serial clock limit */
+#define GPIO_CALIBRATE 256 /* bytes clocked out (CS high) to measure the real rate */
+
+typedef struct
+{
+    volatile uint32_t *regs;
+    uint32_t sclk, din, dc, cs, rst; /* pin masks */
+    uint32_t spins; /* busy-wait iterations per half clock period */
+    uint32_t hz; /* measured SCLK rate */
+} gpiomem_ctx_t;
+
+static void __spin(uint32_t n)
+{
+    volatile uint32_t i;
+    for(i=0; i<n; ++i);
+}
+
+static uint64_t __nsnow(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000000000ULL+t.tv_nsec;
+}
+
+/* one bit as two edges: data with falling SCLK, then rising SCLK (SCLK idles low) */
+#define GPIO_BIT(b) \
+{ \
+    if(v&(b)) \
+    { \
+        clr[0] = sclk; \
+        set[0] = din; \
+    } \
+    else clr[0] = sclk|din; \
+    __spin(spins); \
+    set[0] = sclk; \
+    __spin(spins); \
+}
+
+static void __shiftout(gpiomem_ctx_t *g, const uint8_t *c, uint16_t n)
+{
+    volatile uint32_t *set = g->regs+GPIO_GPSET0, *clr = g->regs+GPIO_GPCLR0;
+    uint32_t sclk = g->sclk, din = g->din, spins = g->spins;
+    uint8_t v;
+    while(n--)
+    {
+        v = *c++;
+        GPIO_BIT(0x80);
+        GPIO_BIT(0x40);
+        GPIO_BIT(0x20);
+        GPIO_BIT(0x10);
+        GPIO_BIT(0x08);
+        GPIO_BIT(0x04);
+        GPIO_BIT(0x02);
+        GPIO_BIT(0x01);
+    }
+    clr[0] = sclk;
+}
+
+static void gpiomem_write(void *ctx, const uint8_t *c, uint16_t n)
+{
+    gpiomem_ctx_t *g = (gpiomem_ctx_t*)ctx;
+    g->regs[GPIO_GPCLR0] = g->cs;
+    __shiftout(g, c, n);
+    g->regs[GPIO_GPSET0] = g->cs;
+}
+
+static void gpiomem_setdc(void *ctx, uint8_t level)
+{
+    gpiomem_ctx_t *g = (gpiomem_ctx_t*)ctx;
+    g->regs[level?GPIO_GPSET0:GPIO_GPCLR0] = g->dc;
+}
+
+static void gpiomem_flush(void *ctx)
+{
+    (void)ctx;
+}
+
+static void gpiomem_reset(void *ctx)
+{
+    gpiomem_ctx_t *g = (gpiomem_ctx_t*)ctx;
+    usleep(1000);
+    g->regs[GPIO_GPCLR0] = g->rst;
+    usleep(500000);
+    g->regs[GPIO_GPSET0] = g->rst;
+}
+
+static void gpiomem_close(void *ctx)
+{
+    gpiomem_ctx_t *g = (gpiomem_ctx_t*)ctx;
+    munmap((void*)g->regs, GPIO_MAPSIZE);
+    free(g);
+}
+
+static void __output(volatile uint32_t *regs, uint8_t pin)
+{
+    uint32_t f = regs[GPIO_GPFSEL0+pin/10];
+    f &= ~(7UL<<((pin%10)*3));
+    f |= 1UL<<((pin%10)*3);
+    regs[GPIO_GPFSEL0+pin/10] = f;
+}
+
+/* fastest of three timed dummy transfers; CS stays high, so the panel ignores them */
+static uint64_t __timeshift(gpiomem_ctx_t *g, const uint8_t *dummy)
+{
+    uint64_t t0, ns, best = ~0ULL;
+    uint8_t i;
+    for(i=0; i<3; ++i)
+    {
+        t0 = __nsnow();
+        __shiftout(g, dummy, GPIO_CALIBRATE);
+        ns = __nsnow()-t0;
+        if(ns<best) best = ns;
+    }
+    return best?best:1;
+}
+
+/* fits transfer time = fixed + spins*cost, refines it, then only ever slows down until SCLK <= hz */
+static void __calibrate(gpiomem_ctx_t *g, uint32_t hz)
+{
+    uint8_t dummy[GPIO_CALIBRATE];
+    uint64_t target = 1000000000ULL*8*GPIO_CALIBRATE/hz, ns0, ns1, ns;
+    uint32_t probe = 64;
+    uint8_t i;
+    memset(dummy, 0x55, sizeof(dummy));
+    g->spins = 0;
+    ns0 = __timeshift(g, dummy);
+    g->spins = probe;
+    ns1 = __timeshift(g, dummy);
+    if((ns0>=target)||(ns1<=ns0)) g->spins = 0;
+    else g->spins = (uint32_t)((target-ns0)*probe/(ns1-ns0));
+    ns = __timeshift(g, dummy);
+    for(i=0; (i<4)&&g->spins&&(ns>ns0)&&((ns*20<target*19)||(ns*20>target*21)); ++i)
+    {
+        /* the spin cost is not quite linear in its count, so refine on the real thing */
+        g->spins = (uint32_t)((uint64_t)g->spins*(target-ns0)/(ns-ns0));
+        ns = __timeshift(g, dummy);
+    }
+    for(i=0; (i<16)&&(ns<target); ++i)
+    {
+        g->spins += g->spins/8+1;
+        ns = __timeshift(g, dummy);
+    }
+    g->hz = (uint32_t)(1000000000ULL*8*GPIO_CALIBRATE/ns);
+}
+
+/** \endcond */
+
+/** \brief Sets up the register-level GPIO bit-banging backend
+ *
+ * The GPIO set/clear registers are written directly through a mapping of
+ * gpiomem, each byte unrolled into 16 clock edges. The half-period busy-wait
+ * is calibrated at setup by timing a dummy transfer with CS high, so that
+ * SCLK does not exceed the requested rate. Any regular file of at least one
+ * page may stand in for /dev/gpiomem.
+ *
+ * \param[out] t pcd8544_transport_t* Transport to fill
+ * \param[in] gpiomem const char* GPIO register device (e.g. "/dev/gpiomem")
+ * \param[in] SCLK uint8_t Clock (BCM GPIO number)
+ * \param[in] DIN uint8_t Data in (BCM GPIO number)
+ * \param[in] DC uint8_t Data/Command (BCM GPIO number)
+ * \param[in] CS uint8_t Chip Select (BCM GPIO number)
+ * \param[in] RST uint8_t Reset (BCM GPIO number)
+ * \param[in] speed uint32_t SCLK rate in Hz (0 or above 4000000 - 4000000)
+ * \return int 0 on success, -1 on failure
+ *
+ */
+
+int LCDgpiomemTransport(pcd8544_transport_t *t, const char *gpiomem, uint8_t SCLK, uint8_t DIN, uint8_t DC, uint8_t CS, uint8_t RST, uint32_t speed)
+{
+    gpiomem_ctx_t *g;
+    struct stat st;
+    void *map;
+    int fd;
+    if((SCLK>31)||(DIN>31)||(DC>31)||(CS>31)||(RST>31))
+    {
+        printf("GPIO pin out of range.\n");
+        return -1;
+    }
+    fd = open(gpiomem, O_RDWR|O_SYNC);
+    if(fd<0)
+    {
+        printf("Cannot open %s.\n", gpiomem);
+        return -1;
+    }
+    if((fstat(fd, &st)==0)&&S_ISREG(st.st_mode)&&(st.st_size<GPIO_MAPSIZE)&&(ftruncate(fd, GPIO_MAPSIZE)<0))
+    {
+        printf("Cannot open %s.\n", gpiomem);
+        close(fd);
+        return -1;
+    }
+    map = mmap(NULL, GPIO_MAPSIZE, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map==MAP_FAILED)
+    {
+        printf("GPIO mapping failed.\n");
+        return -1;
+    }
+    g = (gpiomem_ctx_t*)malloc(sizeof(gpiomem_ctx_t));
+    if(g==NULL)
+    {
+        printf("Transport allocation failed.\n");
+        munmap(map, GPIO_MAPSIZE);
+        return -1;
+    }
+    g->regs = (volatile uint32_t*)map;
+    g->sclk = 1UL<<SCLK;
+    g->din = 1UL<<DIN;
+    g->dc = 1UL<<DC;
+    g->cs = 1UL<<CS;
+    g->rst = 1UL<<RST;
+    g->regs[GPIO_GPSET0] = g->cs|g->rst;
+    g->regs[GPIO_GPCLR0] = g->sclk;
+    __output(g->regs, SCLK);
+    __output(g->regs, DIN);
+    __output(g->regs, DC);
+    __output(g->regs, CS);
+    __output(g->regs, RST);
+    __calibrate(g, ((speed==0)||(speed>GPIO_MAX_HZ))?GPIO_MAX_HZ:speed);
+    t->command = gpiomem_write;
+    t->data = gpiomem_write;
+    t->setdc = gpiomem_setdc;
+    t->flush = gpiomem_flush;
+    t->reset = gpiomem_reset;
+    t->close = gpiomem_close;
+    t->ctx = g;
+    return 0;
+}
+
+/** \brief Returns the SCLK rate measured when a bit-banging backend was set up
+ *
+ * \param[in] t pcd8544_transport_t* Transport set up by LCDgpiomemTransport or LCDbitbangTransport
+ * \return uint32_t Measured rate in Hz, 0 for other backends
+ *
+ */
+
+uint32_t LCDbitbangRate(const pcd8544_transport_t *t)
+{
+    if(t->command!=gpiomem_write) return 0;
+    return ((gpiomem_ctx_t*)t->ctx)->hz;
+}
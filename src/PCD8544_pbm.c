@@ -0,0 +1,147 @@
+/**
+ * @file PCD8544_pbm.c
+ * @brief This file contains PBM image dumping and comparison for PCD8544 display.
+ * @author Sk. Mohammadul Haque, Andre Wussow, Limor Fried (originally)
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque (this version)
+ * Copyright (c) 2012 Andre Wussow (Raspberry Pi version)
+ * Copyright (c) 2010 Limor Fried, Adafruit Industries
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <ctype.h>
+#include "../include/PCD8544.h"
+
+/** \cond HIDDEN_SYMBOLS */
+
+#define PBM_ROWBYTES ((LCDWIDTH+7)/8)
+
+/* reads the next header number, skipping whitespace and comments */
+static int __pbmnumber(FILE *f)
+{
+    int c, v = 0, n = 0;
+    while((c = fgetc(f))!=EOF)
+    {
+        if(c=='#')
+        {
+            while(((c = fgetc(f))!=EOF)&&(c!='\n'));
+        }
+        else if(!isspace(c)) break;
+    }
+    while((c!=EOF)&&isdigit(c))
+    {
+        v = v*10+(c-'0');
+        ++n;
+        c = fgetc(f);
+    }
+    return n?v:-1;
+}
+
+/** \endcond */
+
+/** \brief Saves the drawing buffer as a binary PBM image (black - 1)
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] path char* File name
+ * \return int 0 on success, -1 on failure
+ *
+ */
+
+int pcd8544_savePBM(pcd8544_t *lcd, const char *path)
+{
+    uint8_t row[PBM_ROWBYTES], x, y;
+    FILE *f = fopen(path, "wb");
+    if(f==NULL)
+    {
+        printf("Cannot open %s.\n", path);
+        return -1;
+    }
+    fprintf(f, "P4\n%d %d\n", LCDWIDTH, LCDHEIGHT);
+    for(y=0; y<LCDHEIGHT; ++y)
+    {
+        for(x=0; x<PBM_ROWBYTES; ++x) row[x] = 0;
+        for(x=0; x<LCDWIDTH; ++x)
+        {
+            if(pcd8544_getPixel(lcd, x, y)) row[x>>3] |= 0x80>>(x&7);
+        }
+        fwrite(row, 1, PBM_ROWBYTES, f);
+    }
+    if(fclose(f)!=0) return -1;
+    return 0;
+}
+
+/** \brief Compares the drawing buffer with a PBM image
+ *
+ * Both the binary (P4) and the plain (P1) formats are read.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] path char* File name
+ * \return int Number of differing pixels, -1 if the image cannot be read or has the wrong size
+ *
+ */
+
+int pcd8544_comparePBM(pcd8544_t *lcd, const char *path)
+{
+    uint8_t row[PBM_ROWBYTES], x, y, v;
+    int c, plain, diff = 0;
+    FILE *f = fopen(path, "rb");
+    if(f==NULL)
+    {
+        printf("Cannot open %s.\n", path);
+        return -1;
+    }
+    if((fgetc(f)!='P')||(((c = fgetc(f))!='1')&&(c!='4')))
+    {
+        printf("%s is not a PBM image.\n", path);
+        fclose(f);
+        return -1;
+    }
+    plain = (c=='1');
+    if((__pbmnumber(f)!=LCDWIDTH)||(__pbmnumber(f)!=LCDHEIGHT))
+    {
+        printf("%s is not %dx%d.\n", path, LCDWIDTH, LCDHEIGHT);
+        fclose(f);
+        return -1;
+    }
+    for(y=0; y<LCDHEIGHT; ++y)
+    {
+        if(!plain&&(fread(row, 1, PBM_ROWBYTES, f)!=PBM_ROWBYTES)) diff = -1;
+        for(x=0; (x<LCDWIDTH)&&(diff>=0); ++x)
+        {
+            if(plain)
+            {
+                while(((c = fgetc(f))!=EOF)&&(c!='0')&&(c!='1'));
+                if(c==EOF)
+                {
+                    diff = -1;
+                    break;
+                }
+                v = (c=='1');
+            }
+            else v = (row[x>>3]>>(7-(x&7)))&0x1;
+            if(v!=pcd8544_getPixel(lcd, x, y)) ++diff;
+        }
+        if(diff<0)
+        {
+            printf("%s is truncated.\n", path);
+            break;
+        }
+    }
+    fclose(f);
+    return diff;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file PCD8544_player.c
+ * @brief This file contains the animation player for PCD8544 display.
+ * @author Sk. Mohammadul Haque, Andre Wussow, Limor Fried (originally)
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque (this version)
+ * Copyright (c) 2012 Andre Wussow (Raspberry Pi version)
+ * Copyright (c) 2010 Limor Fried, Adafruit Industries
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "../include/PCD8544.h"
+
+/** \cond HIDDEN_SYMBOLS */
+
+static uint64_t monotonic_now(void *ctx)
+{
+    struct timespec t;
+    (void)ctx;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec*1000000000ULL+t.tv_nsec;
+}
+
+static void monotonic_sleepuntil(void *ctx, uint64_t t)
+{
+    struct timespec ts;
+    (void)ctx;
+    ts.tv_sec = t/1000000000ULL;
+    ts.tv_nsec = t%1000000000ULL;
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)==EINTR);
+}
+
+static uint64_t mock_now(void *ctx)
+{
+    return ((pcd8544_mock_t*)ctx)->now;
+}
+
+static void mock_sleepuntil(void *ctx, uint64_t t)
+{
+    pcd8544_mock_t *m = (pcd8544_mock_t*)ctx;
+    if(t>m->now) m->now = t;
+}
+
+/* draws frames[index] into the buffer and moves index on */
+static int __playerdraw(pcd8544_t *lcd, pcd8544_player_t *p)
+{
+    if(p->sizes)
+    {
+        if(pcd8544_drawframe(lcd, p->frames[p->index], p->sizes[p->index])<0) return -1;
+    }
+    else pcd8544_drawbitframe(lcd, p->frames[p->index], LCD_POS);
+    if((++p->index==p->count)&&p->loop) p->index = 0;
+    return 0;
+}
+
+static uint8_t __playerdone(const pcd8544_player_t *p)
+{
+    return (p->count==0)||((!p->loop)&&(p->index>=p->count));
+}
+
+/** \endcond */
+
+/** \brief Sets up an animation player
+ *
+ * Frames are either raw (sizes NULL) or compressed with LCDencodeFrame,
+ * in which case each may be a delta against the one before it. A looping
+ * delta sequence must start with a frame coded without a previous frame.
+ * The player runs on CLOCK_MONOTONIC until another clock is installed.
+ * It plays once; set p->loop to repeat.
+ *
+ * \param[out] p pcd8544_player_t* Player state
+ * \param[in] frames uint8_t** Frames
+ * \param[in] sizes uint16_t* Compressed frame sizes or NULL for raw frames
+ * \param[in] count uint16_t Number of frames
+ * \param[in] fps uint16_t Target frames per second
+ *
+ */
+
+void LCDplayerInit(pcd8544_player_t *p, const uint8_t *const *frames, const uint16_t *sizes, uint16_t count, uint16_t fps)
+{
+    memset(p, 0, sizeof(pcd8544_player_t));
+    p->frames = frames;
+    p->sizes = sizes;
+    p->count = count;
+    p->loop = 0;
+    p->interval_ns = 1000000000UL/(fps?fps:1);
+    p->now = monotonic_now;
+    p->sleepuntil = monotonic_sleepuntil;
+}
+
+/** \brief Runs a player on the virtual clock of a mock backend
+ *
+ * Sleeping advances m->now to the deadline and every byte written advances
+ * it by m->byte_ns, so schedules can be checked without waiting.
+ *
+ * \param[in,out] p pcd8544_player_t* Player state
+ * \param[in] m pcd8544_mock_t* Mock state
+ *
+ */
+
+void LCDplayerMockClock(pcd8544_player_t *p, pcd8544_mock_t *m)
+{
+    p->now = mock_now;
+    p->sleepuntil = mock_sleepuntil;
+    p->clock_ctx = m;
+}
+
+/** \brief Shows the next frame at its deadline
+ *
+ * Deadlines are absolute, start+k*interval, so lateness does not accumulate.
+ * When the player falls behind, the frames whose deadlines have passed are
+ * still drawn into the buffer (deltas depend on them) but only the newest
+ * is sent, and the others are counted as dropped. Only changed bytes reach
+ * the display.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in,out] p pcd8544_player_t* Player state
+ * \return int 1 when the animation has ended, 0 otherwise, -1 on a corrupt frame
+ *
+ */
+
+int pcd8544_playerStep(pcd8544_t *lcd, pcd8544_player_t *p)
+{
+    uint64_t t, deadline;
+    uint32_t due;
+    if(__playerdone(p)) return 1;
+    if(!p->started)
+    {
+        p->start = p->now(p->clock_ctx);
+        p->frame = 0;
+        p->started = 1;
+    }
+    deadline = p->start+(uint64_t)p->frame*p->interval_ns;
+    t = p->now(p->clock_ctx);
+    if(t<deadline)
+    {
+        p->sleepuntil(p->clock_ctx, deadline);
+        t = p->now(p->clock_ctx);
+    }
+    due = (uint32_t)((t-p->start)/p->interval_ns);
+    while((p->frame<due)&&(p->loop||((p->index+1)<p->count)))
+    {
+        if(__playerdraw(lcd, p)<0) return -1;
+        ++p->frame;
+        ++p->dropped;
+    }
+    if(__playerdraw(lcd, p)<0) return -1;
+    deadline = p->start+(uint64_t)p->frame*p->interval_ns;
+    if((t-deadline)>p->max_late_ns) p->max_late_ns = t-deadline;
+    pcd8544_update(lcd);
+    if(p->now(p->clock_ctx)>(deadline+p->interval_ns)) ++p->late;
+    ++p->shown;
+    ++p->frame;
+    return __playerdone(p);
+}
+
+/** \brief Plays an animation to its end
+ *
+ * A looping player never ends; drive it with pcd8544_playerStep instead.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in,out] p pcd8544_player_t* Player state
+ * \return int 0 on success, -1 on a corrupt frame
+ *
+ */
+
+int pcd8544_play(pcd8544_t *lcd, pcd8544_player_t *p)
+{
+    int r;
+    while((r = pcd8544_playerStep(lcd, p))==0);
+    return (r<0)?-1:0;
+}
+
+/** \brief Shows the next frame at its deadline (default display)
+ *
+ * \param[in,out] p pcd8544_player_t* Player state
+ * \return int 1 when the animation has ended, 0 otherwise, -1 on a corrupt frame
+ *
+ */
+
+int LCDplayerStep(pcd8544_player_t *p)
+{
+    return pcd8544_playerStep(pcd8544_default(), p);
+}
+
+/** \brief Plays an animation to its end (default display)
+ *
+ * \param[in,out] p pcd8544_player_t* Player state
+ * \return int 0 on success, -1 on a corrupt frame
+ *
+ */
+
+int LCDplay(pcd8544_player_t *p)
+{
+    return pcd8544_play(pcd8544_default(), p);
+}
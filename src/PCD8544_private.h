@@ -0,0 +1,81 @@
+/**
+ * @file PCD8544_private.h
+ * @brief This file contains the display instance layout shared by the library sources.
+ * @author Sk. Mohammadul Haque, Andre Wussow, Limor Fried (originally)
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque (this version)
+ * Copyright (c) 2012 Andre Wussow (Raspberry Pi version)
+ * Copyright (c) 2010 Limor Fried, Adafruit Industries
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef PCD8544_PRIVATE_H
+#define PCD8544_PRIVATE_H
+
+#include <pthread.h>
+#include "../include/PCD8544.h"
+
+/** \cond HIDDEN_SYMBOLS */
+
+#define LCDPAGES (LCDHEIGHT/8)
+#define LCDBYTES (LCDWIDTH*LCDHEIGHT/8)
+
+#define DIRTY_SPANS 2 /* dirty column spans kept per page */
+typedef struct
+{
+    uint8_t n;
+    uint8_t x0[DIRTY_SPANS], x1[DIRTY_SPANS];
+} dirty_page_t;
+
+struct pcd8544
+{
+    uint8_t *buffer; /* drawing buffer, fb unless the default instance */
+    pcd8544_canvas_t screen; /* the drawing buffer as a canvas */
+    uint8_t cursor_x, cursor_y, textsize, textcolor;
+    const pcd8544_font_t *textfont;
+    pcd8544_transport_t transport;
+    uint8_t dc;
+    dirty_page_t dirty[LCDPAGES];
+
+    uint8_t shadow[LCDBYTES]; /* what the panel currently shows */
+    uint8_t diffmode, shadow_valid;
+
+    pthread_t flush_thread;
+    pthread_mutex_t flush_lock, bus_lock;
+    pthread_cond_t flush_cond, idle_cond;
+    uint8_t async_enabled, flush_stop, flush_busy, pending;
+    uint8_t async_buffers[2][LCDBYTES];
+    uint8_t *back_buffer, *send_buffer;
+    dirty_page_t back_dirty[LCDPAGES];
+    uint32_t frame_interval_ns;
+
+#ifdef PCD8544_STATS
+    pcd8544_stats_t stats;
+    uint64_t stats_t0, stats_bytes0; /* start of the transfer in progress */
+#endif
+
+    uint8_t fb[LCDBYTES];
+};
+
+#ifdef PCD8544_STATS
+#define STATS(x) x
+#else
+#define STATS(x) /* compiled out */
+#endif
+
+/** \endcond */
+
+#endif // PCD8544_PRIVATE_H
@@ -0,0 +1,569 @@
+/**
+ * @file PCD8544_queue.c
+ * @brief This file contains the draw command queue and render thread for PCD8544 display.
+ * @author Sk. Mohammadul Haque, Andre Wussow, Limor Fried (originally)
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque (this version)
+ * Copyright (c) 2012 Andre Wussow (Raspberry Pi version)
+ * Copyright (c) 2010 Limor Fried, Adafruit Industries
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "../include/PCD8544.h"
+
+/** \cond HIDDEN_SYMBOLS */
+
+#define Q_PIXEL 0
+#define Q_LINE 1
+#define Q_RECT 2
+#define Q_FILLRECT 3
+#define Q_HLINE 4
+#define Q_VLINE 5
+#define Q_CIRCLE 6
+#define Q_FILLCIRCLE 7
+#define Q_BITMAP 8
+#define Q_STRING 9
+#define Q_ZERO 10
+#define Q_UPDATE 11
+#define Q_DISPLAY 12
+
+#define Q_CACHELINE 64
+
+typedef struct
+{
+    uint8_t op, color, size;
+    int16_t a[4];
+    const void *p; /* bitmap or font */
+    char text[LCD_QUEUE_TEXT+1];
+} qcmd_t;
+
+/* a slot is free for the producer at position pos when seq==pos and holds
+ * a command for the consumer when seq==pos+1 */
+typedef struct
+{
+    atomic_uint seq;
+    qcmd_t cmd;
+} qslot_t;
+
+struct pcd8544_queue
+{
+    pcd8544_t *lcd;
+    qslot_t *slots;
+    uint32_t mask;
+    pthread_t thread;
+    sem_t wake;
+    pthread_mutex_t done_lock;
+    pthread_cond_t done_cond;
+    uint32_t done; /* commands executed and flushed, under done_lock */
+    atomic_uint commands, batches, updates, dropped;
+    atomic_int sleeping, stop;
+    char pad0[Q_CACHELINE];
+    atomic_uint head; /* next position to reserve, shared by the producers */
+    char pad1[Q_CACHELINE];
+    uint32_t tail; /* next position to consume, render thread only */
+};
+
+static int __enqueue(pcd8544_queue_t *q, const qcmd_t *c)
+{
+    qslot_t *s;
+    uint32_t pos = atomic_load_explicit(&q->head, memory_order_relaxed), seq;
+    int32_t dif;
+    for(;;)
+    {
+        s = q->slots+(pos&q->mask);
+        seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        dif = (int32_t)(seq-pos);
+        if(dif==0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&q->head, &pos, pos+1, memory_order_relaxed, memory_order_relaxed)) break;
+        }
+        else if(dif<0)
+        {
+            atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+            return -1;
+        }
+        else pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    }
+    s->cmd = *c;
+    atomic_store_explicit(&s->seq, pos+1, memory_order_release);
+    /* pairs with the fence in __renderer before it rechecks the ring */
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load_explicit(&q->sleeping, memory_order_relaxed)&&atomic_exchange(&q->sleeping, 0)) sem_post(&q->wake);
+    return 0;
+}
+
+static uint8_t __dequeue(pcd8544_queue_t *q, qcmd_t *c)
+{
+    qslot_t *s = q->slots+(q->tail&q->mask);
+    if(atomic_load_explicit(&s->seq, memory_order_acquire)!=(q->tail+1)) return 0;
+    *c = s->cmd;
+    atomic_store_explicit(&s->seq, q->tail+q->mask+1, memory_order_release);
+    ++q->tail;
+    return 1;
+}
+
+static uint8_t __ready(pcd8544_queue_t *q)
+{
+    return atomic_load_explicit(&q->slots[q->tail&q->mask].seq, memory_order_acquire)==(q->tail+1);
+}
+
+static void __execute(pcd8544_t *lcd, qcmd_t *c)
+{
+    switch(c->op)
+    {
+    case Q_PIXEL:
+        pcd8544_setPixel(lcd, c->a[0], c->a[1], c->color);
+        break;
+    case Q_LINE:
+        pcd8544_drawline(lcd, c->a[0], c->a[1], c->a[2], c->a[3], c->color);
+        break;
+    case Q_RECT:
+        pcd8544_drawrect(lcd, c->a[0], c->a[1], c->a[2], c->a[3], c->color);
+        break;
+    case Q_FILLRECT:
+        pcd8544_fillrect(lcd, c->a[0], c->a[1], c->a[2], c->a[3], c->color);
+        break;
+    case Q_HLINE:
+        pcd8544_drawhline(lcd, c->a[0], c->a[1], c->a[2], c->color);
+        break;
+    case Q_VLINE:
+        pcd8544_drawvline(lcd, c->a[0], c->a[1], c->a[2], c->color);
+        break;
+    case Q_CIRCLE:
+        pcd8544_drawcircle(lcd, c->a[0], c->a[1], c->a[2], c->color);
+        break;
+    case Q_FILLCIRCLE:
+        pcd8544_fillcircle(lcd, c->a[0], c->a[1], c->a[2], c->color);
+        break;
+    case Q_BITMAP:
+        pcd8544_blitbitmap(lcd, c->a[0], c->a[1], (const uint8_t*)c->p, c->a[2], c->a[3], c->color);
+        break;
+    case Q_STRING:
+        pcd8544_setFont(lcd, (const pcd8544_font_t*)c->p);
+        pcd8544_setTextSize(lcd, c->size);
+        pcd8544_setTextColor(lcd, c->color);
+        pcd8544_drawstring(lcd, c->a[0], c->a[1], c->text);
+        break;
+    case Q_ZERO:
+        pcd8544_zero(lcd);
+        break;
+    }
+}
+
+/* drains at most one ring's worth of commands per batch so a steady stream
+ * of producers cannot hold the display back, then sends once */
+static void *__renderer(void *arg)
+{
+    pcd8544_queue_t *q = (pcd8544_queue_t*)arg;
+    qcmd_t c;
+    uint32_t n;
+    uint8_t send;
+    for(;;)
+    {
+        for(n=0, send=0; (n<=q->mask)&&__dequeue(q, &c); ++n)
+        {
+            if(c.op==Q_UPDATE) send |= 1;
+            else if(c.op==Q_DISPLAY) send |= 2;
+            else __execute(q->lcd, &c);
+        }
+        if(send&2) pcd8544_display(q->lcd);
+        else if(send) pcd8544_update(q->lcd);
+        if(send) atomic_fetch_add_explicit(&q->updates, 1, memory_order_relaxed);
+        if(n)
+        {
+            atomic_fetch_add_explicit(&q->commands, n, memory_order_relaxed);
+            atomic_fetch_add_explicit(&q->batches, 1, memory_order_relaxed);
+            pthread_mutex_lock(&q->done_lock);
+            q->done = q->tail;
+            pthread_cond_broadcast(&q->done_cond);
+            pthread_mutex_unlock(&q->done_lock);
+            continue;
+        }
+        if(atomic_load(&q->stop)) break;
+        atomic_store(&q->sleeping, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        if(__ready(q)||atomic_load(&q->stop))
+        {
+            atomic_store(&q->sleeping, 0);
+            continue;
+        }
+        while(sem_wait(&q->wake)!=0);
+    }
+    return NULL;
+}
+
+static void __cmd(qcmd_t *c, uint8_t op, int16_t a0, int16_t a1, int16_t a2, int16_t a3, uint8_t color)
+{
+    c->op = op;
+    c->color = color;
+    c->a[0] = a0;
+    c->a[1] = a1;
+    c->a[2] = a2;
+    c->a[3] = a3;
+}
+
+static int __post(pcd8544_queue_t *q, uint8_t op, int16_t a0, int16_t a1, int16_t a2, int16_t a3, uint8_t color)
+{
+    qcmd_t c;
+    __cmd(&c, op, a0, a1, a2, a3, color);
+    return __enqueue(q, &c);
+}
+
+/** \endcond */
+
+/** \brief Starts a render thread fed by a draw command queue
+ *
+ * Any number of threads may then draw through the LCDqueue calls, which
+ * copy a small command into a lock-free ring and return without touching
+ * the display. The render thread alone draws into the buffer and talks to
+ * the bus, so nothing else may use the display until LCDqueueDestroy. Each
+ * time it wakes it executes everything queued and sends one update for all
+ * the LCDqueueUpdate requests among them.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in] capacity uint16_t Ring size in commands, rounded up to a power of 2
+ * \return pcd8544_queue_t* Queue handle, NULL on failure
+ *
+ */
+
+pcd8544_queue_t *pcd8544_queueCreate(pcd8544_t *lcd, uint16_t capacity)
+{
+    pcd8544_queue_t *q;
+    uint32_t n = 2, i;
+    while(n<capacity) n <<= 1;
+    q = (pcd8544_queue_t*)calloc(1, sizeof(pcd8544_queue_t));
+    if(q!=NULL) q->slots = (qslot_t*)calloc(n, sizeof(qslot_t));
+    if((q==NULL)||(q->slots==NULL))
+    {
+        printf("Queue allocation failed.\n");
+        free(q);
+        return NULL;
+    }
+    q->lcd = lcd;
+    q->mask = n-1;
+    for(i=0; i<n; ++i) atomic_init(&q->slots[i].seq, i);
+    sem_init(&q->wake, 0, 0);
+    pthread_mutex_init(&q->done_lock, NULL);
+    pthread_cond_init(&q->done_cond, NULL);
+    if(pthread_create(&q->thread, NULL, __renderer, q)!=0)
+    {
+        printf("Render thread creation failed.\n");
+        sem_destroy(&q->wake);
+        pthread_mutex_destroy(&q->done_lock);
+        pthread_cond_destroy(&q->done_cond);
+        free(q->slots);
+        free(q);
+        return NULL;
+    }
+    return q;
+}
+
+/** \brief Starts a render thread fed by a draw command queue (default display)
+ *
+ * \param[in] capacity uint16_t Ring size in commands, rounded up to a power of 2
+ * \return pcd8544_queue_t* Queue handle, NULL on failure
+ *
+ */
+
+pcd8544_queue_t *LCDqueueCreate(uint16_t capacity)
+{
+    return pcd8544_queueCreate(pcd8544_default(), capacity);
+}
+
+/** \brief Executes what is queued and stops the render thread
+ *
+ * No other thread may still be drawing through the queue.
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ *
+ */
+
+void LCDqueueDestroy(pcd8544_queue_t *q)
+{
+    if(q==NULL) return;
+    LCDqueueSync(q);
+    atomic_store(&q->stop, 1);
+    sem_post(&q->wake);
+    pthread_join(q->thread, NULL);
+    sem_destroy(&q->wake);
+    pthread_mutex_destroy(&q->done_lock);
+    pthread_cond_destroy(&q->done_cond);
+    free(q->slots);
+    free(q);
+}
+
+/** \brief Waits until every command queued before the call has been executed
+ *
+ * Unlike the drawing calls this blocks, including on any transfer the
+ * commands asked for.
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ *
+ */
+
+void LCDqueueSync(pcd8544_queue_t *q)
+{
+    uint32_t pos = atomic_load(&q->head);
+    pthread_mutex_lock(&q->done_lock);
+    while((int32_t)(q->done-pos)<0) pthread_cond_wait(&q->done_cond, &q->done_lock);
+    pthread_mutex_unlock(&q->done_lock);
+}
+
+/** \brief Reads the queue counters
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[out] s pcd8544_queuestats_t* Counters
+ *
+ */
+
+void LCDqueueGetStats(pcd8544_queue_t *q, pcd8544_queuestats_t *s)
+{
+    s->commands = atomic_load_explicit(&q->commands, memory_order_relaxed);
+    s->batches = atomic_load_explicit(&q->batches, memory_order_relaxed);
+    s->updates = atomic_load_explicit(&q->updates, memory_order_relaxed);
+    s->dropped = atomic_load_explicit(&q->dropped, memory_order_relaxed);
+}
+
+/** \brief Queues a pixel
+ *
+ * This and the other drawing calls never block. When the ring is full the
+ * command is dropped and counted (see LCDqueueGetStats).
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] color uint8_t WHITE/BLACK
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueSetPixel(pcd8544_queue_t *q, uint8_t x, uint8_t y, uint8_t color)
+{
+    return __post(q, Q_PIXEL, x, y, 0, 0, color);
+}
+
+/** \brief Queues a line
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[in] x0 uint8_t Start horizontal position
+ * \param[in] y0 uint8_t Start vertical position
+ * \param[in] x1 uint8_t End horizontal position
+ * \param[in] y1 uint8_t End vertical position
+ * \param[in] color uint8_t WHITE/BLACK
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueDrawline(pcd8544_queue_t *q, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t color)
+{
+    return __post(q, Q_LINE, x0, y0, x1, y1, color);
+}
+
+/** \brief Queues a rectangle outline
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] w uint8_t Width
+ * \param[in] h uint8_t Height
+ * \param[in] color uint8_t WHITE/BLACK
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueDrawrect(pcd8544_queue_t *q, uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color)
+{
+    return __post(q, Q_RECT, x, y, w, h, color);
+}
+
+/** \brief Queues a filled rectangle
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] w uint8_t Width
+ * \param[in] h uint8_t Height
+ * \param[in] color uint8_t WHITE/BLACK
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueFillrect(pcd8544_queue_t *q, uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t color)
+{
+    return __post(q, Q_FILLRECT, x, y, w, h, color);
+}
+
+/** \brief Queues a horizontal line
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] w uint8_t Width
+ * \param[in] color uint8_t WHITE/BLACK
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueDrawhline(pcd8544_queue_t *q, uint8_t x, uint8_t y, uint8_t w, uint8_t color)
+{
+    return __post(q, Q_HLINE, x, y, w, 0, color);
+}
+
+/** \brief Queues a vertical line
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] h uint8_t Height
+ * \param[in] color uint8_t WHITE/BLACK
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueDrawvline(pcd8544_queue_t *q, uint8_t x, uint8_t y, uint8_t h, uint8_t color)
+{
+    return __post(q, Q_VLINE, x, y, h, 0, color);
+}
+
+/** \brief Queues a circle outline
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[in] x0 uint8_t Center horizontal position
+ * \param[in] y0 uint8_t Center vertical position
+ * \param[in] r uint8_t Radius
+ * \param[in] color uint8_t WHITE/BLACK
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueDrawcircle(pcd8544_queue_t *q, uint8_t x0, uint8_t y0, uint8_t r, uint8_t color)
+{
+    return __post(q, Q_CIRCLE, x0, y0, r, 0, color);
+}
+
+/** \brief Queues a filled circle
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[in] x0 uint8_t Center horizontal position
+ * \param[in] y0 uint8_t Center vertical position
+ * \param[in] r uint8_t Radius
+ * \param[in] color uint8_t WHITE/BLACK
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueFillcircle(pcd8544_queue_t *q, uint8_t x0, uint8_t y0, uint8_t r, uint8_t color)
+{
+    return __post(q, Q_FILLCIRCLE, x0, y0, r, 0, color);
+}
+
+/** \brief Queues a bitmap blit
+ *
+ * The bitmap uses the display's page-packed layout: byte i+(j/8)*w holds
+ * rows j..j+7 of column i, LSB on top. Only the pointer is queued, so the
+ * bitmap must stay unchanged until it has been drawn (see LCDqueueSync).
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical position
+ * \param[in] bitmap uint8_t* Page-packed bitmap
+ * \param[in] w uint8_t Width
+ * \param[in] h uint8_t Height
+ * \param[in] rop uint8_t Raster operation (LCD_ROP_COPY/LCD_ROP_OR/LCD_ROP_ANDNOT/LCD_ROP_XOR/LCD_ROP_INVERT/LCD_ROP_AND)
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueBlitbitmap(pcd8544_queue_t *q, int16_t x, int16_t y, const uint8_t *bitmap, uint8_t w, uint8_t h, uint8_t rop)
+{
+    qcmd_t c;
+    __cmd(&c, Q_BITMAP, x, y, w, h, rop);
+    c.p = bitmap;
+    return __enqueue(q, &c);
+}
+
+/** \brief Queues a string
+ *
+ * The text is copied into the command, up to LCD_QUEUE_TEXT characters;
+ * the rest is cut off.
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \param[in] x uint8_t Horizontal position
+ * \param[in] y uint8_t Vertical position
+ * \param[in] str char* String to be printed
+ * \param[in] f pcd8544_font_t* Font or NULL for the built-in one
+ * \param[in] s uint8_t Text size
+ * \param[in] color uint8_t WHITE/BLACK
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueDrawstring(pcd8544_queue_t *q, uint8_t x, uint8_t y, const char *str, const pcd8544_font_t *f, uint8_t s, uint8_t color)
+{
+    qcmd_t c;
+    __cmd(&c, Q_STRING, x, y, 0, 0, color);
+    c.p = f;
+    c.size = s;
+    strncpy(c.text, str, LCD_QUEUE_TEXT);
+    c.text[LCD_QUEUE_TEXT] = '\0';
+    return __enqueue(q, &c);
+}
+
+/** \brief Queues a reset of the drawing buffer
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueZero(pcd8544_queue_t *q)
+{
+    return __post(q, Q_ZERO, 0, 0, 0, 0, 0);
+}
+
+/** \brief Asks for the changes drawn so far to be sent
+ *
+ * Requests reaching the render thread together are sent as one update. A
+ * dropped request is covered by the next one.
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueUpdate(pcd8544_queue_t *q)
+{
+    return __post(q, Q_UPDATE, 0, 0, 0, 0, 0);
+}
+
+/** \brief Asks for the whole drawing buffer to be sent
+ *
+ * \param[in] q pcd8544_queue_t* Queue handle
+ * \return int 0 on success, -1 if the ring is full
+ *
+ */
+
+int LCDqueueDisplay(pcd8544_queue_t *q)
+{
+    return __post(q, Q_DISPLAY, 0, 0, 0, 0, 0);
+}
@@ -0,0 +1,299 @@
+/**
+ * @file PCD8544_spidev.c
+ * @brief This file contains the Linux spidev transport backend for PCD8544 display.
+ * @author Sk. Mohammadul Haque, Andre Wussow, Limor Fried (originally)
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque (this version)
+ * Copyright (c) 2012 Andre Wussow (Raspberry Pi version)
+ * Copyright (c) 2010 Limor Fried, Adafruit Industries
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <linux/spi/spidev.h>
+#include <linux/gpio.h>
+#endif
+#include "../include/PCD8544.h"
+
+/** \cond HIDDEN_SYMBOLS */
+
+#ifdef __linux__
+
+#define SPIDEV_MAX_HZ 4000000 /* PCD8544 serial clock limit */
+#define SPIDEV_TRANSFERS 32 /* transfers batched into one SPI_IOC_MESSAGE */
+#define SPIDEV_STAGE 1024 /* bytes staged before a forced submit */
+#define SPIDEV_BUFSIZ 4096 /* spidev's default per-message limit */
+#define SPIDEV_INPLACE 16 /* shorter data payloads are staged, longer ones sent in place */
+
+typedef struct
+{
+    int fd, dc_fd, rst_fd;
+    uint8_t is_spi; /* 0 - ordinary file or pipe, written with writev */
+    uint32_t speed;
+    uint8_t n;
+    uint16_t staged, total;
+    struct spi_ioc_transfer xfer[SPIDEV_TRANSFERS];
+    uint8_t stage[SPIDEV_STAGE];
+} spidev_ctx_t;
+
+/* sends every queued transfer with a single syscall */
+static void __spidev_submit(spidev_ctx_t *s)
+{
+    struct iovec iov[SPIDEV_TRANSFERS];
+    uint8_t i;
+    if(!s->n) return;
+    if(s->is_spi)
+    {
+        if(ioctl(s->fd, SPI_IOC_MESSAGE(s->n), s->xfer)<0) printf("SPI transfer failed.\n");
+    }
+    else
+    {
+        for(i=0; i<s->n; ++i)
+        {
+            iov[i].iov_base = (void*)(uintptr_t)s->xfer[i].tx_buf;
+            iov[i].iov_len = s->xfer[i].len;
+        }
+        if(writev(s->fd, iov, s->n)<0) printf("SPI transfer failed.\n");
+    }
+    s->n = 0;
+    s->staged = 0;
+    s->total = 0;
+}
+
+static void __spidev_setline(int fd, uint8_t level)
+{
+    struct gpiohandle_data d;
+    if(fd<0) return;
+    memset(&d, 0, sizeof(d));
+    d.values[0] = level?1:0;
+    ioctl(fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &d);
+}
+
+static int __spidev_getline(int chip, uint8_t line, uint8_t level)
+{
+    struct gpiohandle_request r;
+    memset(&r, 0, sizeof(r));
+    r.lineoffsets[0] = line;
+    r.flags = GPIOHANDLE_REQUEST_OUTPUT;
+    r.default_values[0] = level;
+    r.lines = 1;
+    strncpy(r.consumer_label, "PCD8544", sizeof(r.consumer_label)-1);
+    if(ioctl(chip, GPIO_GET_LINEHANDLE_IOCTL, &r)<0) return -1;
+    return r.fd;
+}
+
+static void spidev_write(void *ctx, const uint8_t *c, uint16_t n)
+{
+    spidev_ctx_t *s = (spidev_ctx_t*)ctx;
+    struct spi_ioc_transfer *x;
+    uint16_t k;
+    while(n)
+    {
+        if((s->staged==SPIDEV_STAGE)||(s->total==SPIDEV_BUFSIZ)) __spidev_submit(s);
+        k = SPIDEV_STAGE-s->staged;
+        if(k>(SPIDEV_BUFSIZ-s->total)) k = SPIDEV_BUFSIZ-s->total;
+        if(k>n) k = n;
+        /* extend the last transfer when the staged bytes follow on from it */
+        x = s->n?(s->xfer+s->n-1):NULL;
+        if((x==NULL)||((uintptr_t)x->tx_buf+x->len!=(uintptr_t)(s->stage+s->staged)))
+        {
+            if(s->n==SPIDEV_TRANSFERS)
+            {
+                __spidev_submit(s);
+                continue;
+            }
+            x = s->xfer+s->n++;
+            memset(x, 0, sizeof(struct spi_ioc_transfer));
+            x->tx_buf = (uintptr_t)(s->stage+s->staged);
+            x->speed_hz = s->speed;
+            x->bits_per_word = 8;
+        }
+        memcpy(s->stage+s->staged, c, k);
+        x->len += k;
+        s->staged += k;
+        s->total += k;
+        c += k;
+        n -= k;
+    }
+}
+
+/* the payload is queued by reference; the core keeps it alive until the next setdc or flush */
+static void spidev_data(void *ctx, const uint8_t *c, uint16_t n)
+{
+    spidev_ctx_t *s = (spidev_ctx_t*)ctx;
+    struct spi_ioc_transfer *x;
+    uint16_t k;
+    if(n<SPIDEV_INPLACE)
+    {
+        spidev_write(ctx, c, n);
+        return;
+    }
+    while(n)
+    {
+        if((s->n==SPIDEV_TRANSFERS)||(s->total==SPIDEV_BUFSIZ)) __spidev_submit(s);
+        k = SPIDEV_BUFSIZ-s->total;
+        if(k>n) k = n;
+        x = s->xfer+s->n++;
+        memset(x, 0, sizeof(struct spi_ioc_transfer));
+        x->tx_buf = (uintptr_t)c;
+        x->len = k;
+        x->speed_hz = s->speed;
+        x->bits_per_word = 8;
+        s->total += k;
+        c += k;
+        n -= k;
+    }
+}
+
+/* DC is outside the SPI message, so what was queued under the old level goes first */
+static void spidev_setdc(void *ctx, uint8_t level)
+{
+    spidev_ctx_t *s = (spidev_ctx_t*)ctx;
+    __spidev_submit(s);
+    __spidev_setline(s->dc_fd, level);
+}
+
+static void spidev_flush(void *ctx)
+{
+    __spidev_submit((spidev_ctx_t*)ctx);
+}
+
+static void spidev_reset(void *ctx)
+{
+    spidev_ctx_t *s = (spidev_ctx_t*)ctx;
+    __spidev_submit(s);
+    if(s->rst_fd<0) return;
+    usleep(1000);
+    __spidev_setline(s->rst_fd, 0);
+    usleep(500000);
+    __spidev_setline(s->rst_fd, 1);
+}
+
+static void spidev_close(void *ctx)
+{
+    spidev_ctx_t *s = (spidev_ctx_t*)ctx;
+    __spidev_submit(s);
+    if(s->dc_fd>=0) close(s->dc_fd);
+    if(s->rst_fd>=0) close(s->rst_fd);
+    close(s->fd);
+    free(s);
+}
+
+#endif
+
+/** \endcond */
+
+/** \brief Sets up the Linux spidev backend
+ *
+ * Consecutive writes under the same Data/Command level are batched into one
+ * SPI_IOC_MESSAGE and sent when the level changes or the display flushes.
+ * Commands and short data are staged; longer data is sent from the drawing
+ * buffer in place.
+ * DC and RST are driven through GPIO character-device line handles. If
+ * spidev is an ordinary file or pipe the batches are written to it with
+ * writev instead, and gpiochip may be NULL to run without DC/RST lines.
+ *
+ * \param[out] t pcd8544_transport_t* Transport to fill
+ * \param[in] spidev const char* SPI device (e.g. "/dev/spidev0.0")
+ * \param[in] gpiochip const char* GPIO chip (e.g. "/dev/gpiochip0") or NULL
+ * \param[in] DC uint8_t Data/Command line offset
+ * \param[in] RST uint8_t Reset line offset
+ * \param[in] speed uint32_t SPI clock in Hz (0 or above 4000000 - 4000000)
+ * \return int 0 on success, -1 on failure
+ *
+ */
+
+int LCDspidevTransport(pcd8544_transport_t *t, const char *spidev, const char *gpiochip, uint8_t DC, uint8_t RST, uint32_t speed)
+{
+#ifdef __linux__
+    spidev_ctx_t *s;
+    uint8_t mode = SPI_MODE_0, bits = 8;
+    int chip;
+    s = (spidev_ctx_t*)calloc(1, sizeof(spidev_ctx_t));
+    if(s==NULL)
+    {
+        printf("Transport allocation failed.\n");
+        return -1;
+    }
+    s->dc_fd = s->rst_fd = -1;
+    s->speed = ((speed==0)||(speed>SPIDEV_MAX_HZ))?SPIDEV_MAX_HZ:speed;
+    s->fd = open(spidev, O_WRONLY);
+    if(s->fd<0)
+    {
+        printf("Cannot open %s.\n", spidev);
+        free(s);
+        return -1;
+    }
+    if(ioctl(s->fd, SPI_IOC_WR_MODE, &mode)==0)
+    {
+        s->is_spi = 1;
+        if((ioctl(s->fd, SPI_IOC_WR_BITS_PER_WORD, &bits)<0)||(ioctl(s->fd, SPI_IOC_WR_MAX_SPEED_HZ, &s->speed)<0))
+        {
+            printf("SPI Setup failed.\n");
+            spidev_close(s);
+            return -1;
+        }
+    }
+    else if(errno!=ENOTTY)
+    {
+        printf("SPI Setup failed.\n");
+        spidev_close(s);
+        return -1;
+    }
+    if(gpiochip!=NULL)
+    {
+        chip = open(gpiochip, O_RDONLY);
+        if(chip>=0)
+        {
+            s->dc_fd = __spidev_getline(chip, DC, 0);
+            s->rst_fd = __spidev_getline(chip, RST, 1);
+            close(chip);
+        }
+        if((s->dc_fd<0)||(s->rst_fd<0))
+        {
+            printf("GPIO Setup failed.\n");
+            spidev_close(s);
+            return -1;
+        }
+    }
+    t->command = spidev_write;
+    t->data = spidev_data;
+    t->setdc = spidev_setdc;
+    t->flush = spidev_flush;
+    t->reset = spidev_reset;
+    t->close = spidev_close;
+    t->ctx = s;
+    return 0;
+#else
+    (void)t;
+    (void)spidev;
+    (void)gpiochip;
+    (void)DC;
+    (void)RST;
+    (void)speed;
+    printf("spidev backend not available on this platform.\n");
+    return -1;
+#endif
+}
@@ -0,0 +1,292 @@
+/**
+ * @file PCD8544_transport.c
+ * @brief This file contains the transport backends for PCD8544 display.
+ * @author Sk. Mohammadul Haque, Andre Wussow, Limor Fried (originally)
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque (this version)
+ * Copyright (c) 2012 Andre Wussow (Raspberry Pi version)
+ * Copyright (c) 2010 Limor Fried, Adafruit Industries
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#ifndef PCD8544_NO_WIRINGPI
+#include <wiringPi.h>
+#include <wiringPiSPI.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#endif
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "../include/PCD8544.h"
+
+/** \cond HIDDEN_SYMBOLS */
+
+#ifndef PCD8544_NO_WIRINGPI
+
+typedef struct
+{
+    int8_t dc, rst;
+    int idx; /* SPI file descriptor or bit-bang handle */
+} gpio_ctx_t;
+
+#define SPI_CHUNK 4096 /* spidev's default per-message limit */
+
+static gpio_ctx_t *__newctx(uint8_t DC, uint8_t RST)
+{
+    gpio_ctx_t *g = (gpio_ctx_t*)malloc(sizeof(gpio_ctx_t));
+    if(g==NULL)
+    {
+        printf("Transport allocation failed.\n");
+        return NULL;
+    }
+    g->dc = DC;
+    g->rst = RST;
+    g->idx = 0;
+    if(wiringPiSetup()<0) printf("wiringPi Setup failed.\n");
+    pinMode(DC, OUTPUT);
+    pinMode(RST, OUTPUT);
+    return g;
+}
+
+static void gpio_setdc(void *ctx, uint8_t level)
+{
+    digitalWrite(((gpio_ctx_t*)ctx)->dc, level?HIGH:LOW);
+}
+
+static void gpio_reset(void *ctx)
+{
+    gpio_ctx_t *g = (gpio_ctx_t*)ctx;
+    delay(1);
+    digitalWrite(g->rst, LOW);
+    delay(500);
+    digitalWrite(g->rst, HIGH);
+}
+
+static void gpio_flush(void *ctx)
+{
+    (void)ctx;
+}
+
+static void gpio_close(void *ctx)
+{
+    free(ctx);
+}
+
+/* transmit-only, so the payload is sent in place (wiringPiSPIDataRW would overwrite it) */
+static void spi_write(void *ctx, const uint8_t *c, uint16_t n)
+{
+    struct spi_ioc_transfer x;
+    uint16_t k;
+    while(n)
+    {
+        k = (n>SPI_CHUNK)?SPI_CHUNK:n;
+        memset(&x, 0, sizeof(x));
+        x.tx_buf = (uintptr_t)c;
+        x.len = k;
+        x.bits_per_word = 8;
+        if(ioctl(((gpio_ctx_t*)ctx)->idx, SPI_IOC_MESSAGE(1), &x)<0) printf("SPI transfer failed.\n");
+        c += k;
+        n -= k;
+    }
+}
+
+#endif
+
+static void mock_command(void *ctx, const uint8_t *c, uint16_t n)
+{
+    pcd8544_mock_t *m = (pcd8544_mock_t*)ctx;
+    uint16_t i;
+    m->command_bytes += n;
+    ++m->transactions;
+    m->now += (uint64_t)m->byte_ns*n;
+    for(i=0; i<n; ++i)
+    {
+        uint8_t b = c[i];
+        if(b&0x80)
+        {
+            if(!m->extended) m->x = (b&0x7f)%LCDWIDTH;
+        }
+        else if(b&0x40)
+        {
+            if(!m->extended) m->y = (b&0x07)%(LCDHEIGHT/8);
+        }
+        else if(b&PCD8544_FUNCTIONSET) m->extended = b&PCD8544_EXTENDEDINSTRUCTION;
+    }
+}
+
+static void mock_data(void *ctx, const uint8_t *c, uint16_t n)
+{
+    pcd8544_mock_t *m = (pcd8544_mock_t*)ctx;
+    uint16_t i;
+    m->data_bytes += n;
+    ++m->transactions;
+    m->now += (uint64_t)m->byte_ns*n;
+    for(i=0; i<n; ++i)
+    {
+        m->ram[m->x+m->y*LCDWIDTH] = c[i];
+        if(++m->x>=LCDWIDTH)
+        {
+            m->x = 0;
+            if(++m->y>=(LCDHEIGHT/8)) m->y = 0;
+        }
+    }
+}
+
+static void mock_setdc(void *ctx, uint8_t level)
+{
+    pcd8544_mock_t *m = (pcd8544_mock_t*)ctx;
+    if(m->dc!=level) ++m->dc_toggles;
+    m->dc = level;
+}
+
+static void mock_flush(void *ctx)
+{
+    ++((pcd8544_mock_t*)ctx)->flushes;
+}
+
+static void mock_reset(void *ctx)
+{
+    pcd8544_mock_t *m = (pcd8544_mock_t*)ctx;
+    ++m->resets;
+    m->extended = m->x = m->y = 0;
+}
+
+/** \endcond */
+
+/** \brief Sets up the hardware SPI backend (SPI channel 0)
+ *
+ * \param[out] t pcd8544_transport_t* Transport to fill
+ * \param[in] DC uint8_t Data/Command
+ * \param[in] RST uint8_t Reset
+ * \return int 0 on success, -1 on failure
+ *
+ */
+
+int LCDspiTransport(pcd8544_transport_t *t, uint8_t DC, uint8_t RST)
+{
+    return LCDspiTransportChannel(t, 0, DC, RST);
+}
+
+/** \brief Sets up the hardware SPI backend on a given SPI channel
+ *
+ * \param[out] t pcd8544_transport_t* Transport to fill
+ * \param[in] channel uint8_t SPI channel (chip enable line)
+ * \param[in] DC uint8_t Data/Command
+ * \param[in] RST uint8_t Reset
+ * \return int 0 on success, -1 on failure
+ *
+ */
+
+int LCDspiTransportChannel(pcd8544_transport_t *t, uint8_t channel, uint8_t DC, uint8_t RST)
+{
+#ifndef PCD8544_NO_WIRINGPI
+    gpio_ctx_t *g = __newctx(DC, RST);
+    if(g==NULL) return -1;
+    if((g->idx = wiringPiSPISetup(channel, 2000000))<0)
+    {
+        printf("SPI Setup failed.\n");
+        free(g);
+        return -1;
+    }
+    t->command = spi_write;
+    t->data = spi_write;
+    t->setdc = gpio_setdc;
+    t->flush = gpio_flush;
+    t->reset = gpio_reset;
+    t->close = gpio_close;
+    t->ctx = g;
+    return 0;
+#else
+    (void)t;
+    (void)channel;
+    (void)DC;
+    (void)RST;
+    printf("SPI backend not available (built without wiringPi).\n");
+    return -1;
+#endif
+}
+
+/** \brief Sets up the GPIO bit-banging backend
+ *
+ * Pins are wiringPi numbers; they are converted to BCM numbers and driven
+ * through /dev/gpiomem by LCDgpiomemTransport at the full 4 MHz.
+ *
+ * \param[out] t pcd8544_transport_t* Transport to fill
+ * \param[in] SCLK uint8_t Clock
+ * \param[in] DIN uint8_t Data in
+ * \param[in] DC uint8_t Data/Command
+ * \param[in] CS uint8_t Chip Select
+ * \param[in] RST uint8_t Reset
+ * \return int 0 on success, -1 on failure
+ *
+ */
+
+int LCDbitbangTransport(pcd8544_transport_t *t, uint8_t SCLK, uint8_t DIN, uint8_t DC, uint8_t CS, uint8_t RST)
+{
+#ifndef PCD8544_NO_WIRINGPI
+    if(wiringPiSetup()<0) printf("wiringPi Setup failed.\n");
+    return LCDgpiomemTransport(t, "/dev/gpiomem", wpiPinToGpio(SCLK), wpiPinToGpio(DIN), wpiPinToGpio(DC), wpiPinToGpio(CS), wpiPinToGpio(RST), 0);
+#else
+    (void)t;
+    (void)SCLK;
+    (void)DIN;
+    (void)DC;
+    (void)CS;
+    (void)RST;
+    printf("Bit-bang backend not available (built without wiringPi).\n");
+    return -1;
+#endif
+}
+
+/** \brief Sets up the recording in-memory backend
+ *
+ * The mock counts bytes, Data/Command changes and transactions, and emulates
+ * the controller's address counter so that m->ram mirrors the panel contents.
+ *
+ * \param[out] t pcd8544_transport_t* Transport to fill
+ * \param[in] m pcd8544_mock_t* Mock state
+ *
+ */
+
+void LCDmockTransport(pcd8544_transport_t *t, pcd8544_mock_t *m)
+{
+    memset(m, 0, sizeof(pcd8544_mock_t));
+    t->command = mock_command;
+    t->data = mock_data;
+    t->setdc = mock_setdc;
+    t->flush = mock_flush;
+    t->reset = mock_reset;
+    t->close = NULL;
+    t->ctx = m;
+}
+
+/** \brief Clears the counters of a mock backend
+ *
+ * \param[in] m pcd8544_mock_t* Mock state
+ *
+ */
+
+void LCDmockClear(pcd8544_mock_t *m)
+{
+    m->command_bytes = 0;
+    m->data_bytes = 0;
+    m->dc_toggles = 0;
+    m->transactions = 0;
+    m->flushes = 0;
+    m->resets = 0;
+}
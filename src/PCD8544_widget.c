@@ -0,0 +1,384 @@
+/**
+ * @file PCD8544_widget.c
+ * @brief This file contains the retained widget layer for PCD8544 display.
+ * @author Sk. Mohammadul Haque, Andre Wussow, Limor Fried (originally)
+ * @version 1.0.0.0
+ * @copyright
+ * Copyright (c) 2016 Sk. Mohammadul Haque (this version)
+ * Copyright (c) 2012 Andre Wussow (Raspberry Pi version)
+ * Copyright (c) 2010 Limor Fried, Adafruit Industries
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/PCD8544.h"
+
+/** \cond HIDDEN_SYMBOLS */
+
+static void __widgetinit(pcd8544_widget_t *w, uint8_t type, int16_t x, int16_t y, uint8_t width, uint8_t height)
+{
+    memset(w, 0, sizeof(pcd8544_widget_t));
+    w->type = type;
+    w->x = x;
+    w->y = y;
+    w->w = (width>LCDWIDTH)?LCDWIDTH:width;
+    w->h = (height>LCDHEIGHT)?LCDHEIGHT:height;
+    w->color = BLACK;
+    w->dirty = 1;
+}
+
+/* maps value from min..max onto 0..n, clamped */
+static int32_t __scale(int32_t value, int32_t min, int32_t max, int32_t n)
+{
+    if(max<=min) return 0;
+    if(value<=min) return 0;
+    if(value>=max) return n;
+    return (int32_t)((int64_t)(value-min)*n/(max-min));
+}
+
+static uint8_t __barfill(const pcd8544_widget_t *w, int32_t value)
+{
+    return (w->w>2)?__scale(value, w->u.bar.min, w->u.bar.max, w->w-2):0;
+}
+
+static uint8_t __overlap(const pcd8544_widget_t *a, const pcd8544_widget_t *b)
+{
+    return (a->x<(b->x+b->w))&&(b->x<(a->x+a->w))&&(a->y<(b->y+b->h))&&(b->y<(a->y+a->h));
+}
+
+/* draws the widget at the origin of c, which is exactly its size */
+static void __widgetdraw(const pcd8544_widget_t *w, const pcd8544_canvas_t *c)
+{
+    uint8_t i, x0;
+    LCDcanvasFill(c, !w->color);
+    switch(w->type)
+    {
+    case LCD_WIDGET_LABEL:
+        LCDcanvasDrawstring(c, 0, 0, w->u.label.text, w->u.label.font, w->u.label.size, w->color);
+        break;
+    case LCD_WIDGET_BAR:
+        LCDcanvasDrawrect(c, 0, 0, w->w, w->h, w->color);
+        LCDcanvasFillrect(c, 1, 1, w->u.bar.fill, w->h-2, w->color);
+        break;
+    case LCD_WIDGET_ICON:
+        if(w->u.icon.bitmap) LCDcanvasBlitbitmap(c, 0, 0, w->u.icon.bitmap, w->w, w->h, w->color?LCD_ROP_COPY:LCD_ROP_INVERT);
+        break;
+    case LCD_WIDGET_SPARKLINE:
+        x0 = w->w-w->u.spark.count; /* newest sample on the right */
+        if(w->u.spark.count==1) LCDcanvasSetPixel(c, x0, w->u.spark.rows[0], w->color);
+        for(i=1; i<w->u.spark.count; ++i) LCDcanvasDrawline(c, x0+i-1, w->u.spark.rows[i-1], x0+i, w->u.spark.rows[i], w->color);
+        break;
+    }
+}
+
+/* renders w off-screen, copies it in and marks only the columns that changed */
+static void __widgetrender(pcd8544_t *lcd, const pcd8544_widget_t *w)
+{
+    uint8_t pixels[LCDWIDTH*LCDHEIGHT/8], before[LCDWIDTH*LCDHEIGHT/8];
+    pcd8544_canvas_t c, screen;
+    int16_t x0, x1, y0, y1, p, x, first, last;
+    if(!w->w||!w->h) return;
+    x0 = (w->x<0)?0:w->x;
+    y0 = (w->y<0)?0:w->y;
+    x1 = ((w->x+w->w)>LCDWIDTH)?(LCDWIDTH-1):(w->x+w->w-1);
+    y1 = ((w->y+w->h)>LCDHEIGHT)?(LCDHEIGHT-1):(w->y+w->h-1);
+    if((x0>x1)||(y0>y1)) return;
+    LCDcanvasInit(&c, pixels, w->w, w->h, 0);
+    __widgetdraw(w, &c);
+    pcd8544_getcanvas(lcd, &screen);
+    for(p=(y0>>3); p<=(y1>>3); ++p) memcpy(before+p*LCDWIDTH+x0, screen.buffer+p*screen.stride+x0, x1-x0+1);
+    LCDcanvasBlit(&screen, w->x, w->y, &c, 0, 0, w->w, w->h, LCD_ROP_COPY);
+    for(p=(y0>>3); p<=(y1>>3); ++p)
+    {
+        first = -1;
+        last = -1;
+        for(x=x0; x<=x1; ++x)
+        {
+            if(before[p*LCDWIDTH+x]==screen.buffer[p*screen.stride+x]) continue;
+            if(first<0) first = x;
+            last = x;
+        }
+        if(first>=0) pcd8544_invalidate(lcd, first, p*8, last-first+1, 8);
+    }
+}
+
+/** \endcond */
+
+/** \brief Sets up an empty scene
+ *
+ * A scene is an ordered list of caller-owned widgets. Setting a widget
+ * property only marks it for rendering when the result would look
+ * different; pcd8544_sceneRender then redraws just the marked widgets, and
+ * pcd8544_update sends just the columns whose bytes changed.
+ *
+ * \param[out] s pcd8544_scene_t* Scene
+ *
+ */
+
+void LCDsceneInit(pcd8544_scene_t *s)
+{
+    s->first = NULL;
+    s->last = NULL;
+}
+
+/** \brief Adds a widget on top of a scene
+ *
+ * \param[in,out] s pcd8544_scene_t* Scene
+ * \param[in] w pcd8544_widget_t* Initialized widget (must stay valid while in the scene)
+ *
+ */
+
+void LCDsceneAdd(pcd8544_scene_t *s, pcd8544_widget_t *w)
+{
+    w->next = NULL;
+    w->dirty = 1;
+    if(s->last) s->last->next = w;
+    else s->first = w;
+    s->last = w;
+}
+
+/** \brief Marks every widget of a scene for rendering (e.g. after the display was cleared)
+ *
+ * \param[in,out] s pcd8544_scene_t* Scene
+ *
+ */
+
+void LCDsceneInvalidate(pcd8544_scene_t *s)
+{
+    pcd8544_widget_t *w;
+    for(w=s->first; w; w=w->next) w->dirty = 1;
+}
+
+/** \brief Renders the widgets of a scene that changed
+ *
+ * Each widget is drawn over its whole rect in scene order, so a widget
+ * that overlaps one being redrawn later in the order is redrawn too.
+ * Only the columns whose bytes actually change are marked dirty.
+ *
+ * \param[in] lcd pcd8544_t* Display handle
+ * \param[in,out] s pcd8544_scene_t* Scene
+ * \return int Number of widgets rendered
+ *
+ */
+
+int pcd8544_sceneRender(pcd8544_t *lcd, pcd8544_scene_t *s)
+{
+    pcd8544_widget_t *w, *v;
+    int n = 0;
+    for(w=s->first; w; w=w->next)
+    {
+        if(!w->dirty) continue;
+        __widgetrender(lcd, w);
+        w->dirty = 0;
+        ++n;
+        for(v=w->next; v; v=v->next)
+        {
+            if(__overlap(w, v)) v->dirty = 1;
+        }
+    }
+    return n;
+}
+
+/** \brief Renders the widgets of a scene that changed (default display)
+ *
+ * \param[in,out] s pcd8544_scene_t* Scene
+ * \return int Number of widgets rendered
+ *
+ */
+
+int LCDsceneRender(pcd8544_scene_t *s)
+{
+    return pcd8544_sceneRender(pcd8544_default(), s);
+}
+
+/** \brief Sets up a text label
+ *
+ * Text is drawn from the top left corner of the rect and clipped to it.
+ *
+ * \param[out] w pcd8544_widget_t* Widget
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical position
+ * \param[in] width uint8_t Width
+ * \param[in] height uint8_t Height
+ * \param[in] f pcd8544_font_t* Font (NULL - built-in 5x8 font)
+ * \param[in] size uint8_t Text size (scales the built-in font only)
+ *
+ */
+
+void LCDlabelInit(pcd8544_widget_t *w, int16_t x, int16_t y, uint8_t width, uint8_t height, const pcd8544_font_t *f, uint8_t size)
+{
+    __widgetinit(w, LCD_WIDGET_LABEL, x, y, width, height);
+    w->u.label.font = f;
+    w->u.label.size = size;
+}
+
+/** \brief Sets the text of a label
+ *
+ * \param[in,out] w pcd8544_widget_t* Label
+ * \param[in] text char* Text (cut at LCD_LABEL_MAX characters)
+ *
+ */
+
+void LCDlabelSet(pcd8544_widget_t *w, const char *text)
+{
+    char t[LCD_LABEL_MAX+1];
+    strncpy(t, text, LCD_LABEL_MAX);
+    t[LCD_LABEL_MAX] = '\0';
+    if(!strcmp(t, w->u.label.text)) return;
+    strcpy(w->u.label.text, t);
+    w->dirty = 1;
+}
+
+/** \brief Sets the text of a label to a decimal number
+ *
+ * \param[in,out] w pcd8544_widget_t* Label
+ * \param[in] value int32_t Number
+ *
+ */
+
+void LCDlabelSetNumber(pcd8544_widget_t *w, int32_t value)
+{
+    char t[12];
+    snprintf(t, sizeof(t), "%" PRId32, value);
+    LCDlabelSet(w, t);
+}
+
+/** \brief Sets up a horizontal progress bar
+ *
+ * \param[out] w pcd8544_widget_t* Widget
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical position
+ * \param[in] width uint8_t Width, outline included
+ * \param[in] height uint8_t Height, outline included
+ * \param[in] min int32_t Value shown empty
+ * \param[in] max int32_t Value shown full
+ *
+ */
+
+void LCDbarInit(pcd8544_widget_t *w, int16_t x, int16_t y, uint8_t width, uint8_t height, int32_t min, int32_t max)
+{
+    __widgetinit(w, LCD_WIDGET_BAR, x, y, width, height);
+    w->u.bar.value = min;
+    w->u.bar.min = min;
+    w->u.bar.max = max;
+}
+
+/** \brief Sets the value of a progress bar
+ *
+ * A value that fills the same number of pixels leaves the bar clean.
+ *
+ * \param[in,out] w pcd8544_widget_t* Bar
+ * \param[in] value int32_t Value
+ *
+ */
+
+void LCDbarSet(pcd8544_widget_t *w, int32_t value)
+{
+    uint8_t fill = __barfill(w, value);
+    w->u.bar.value = value;
+    if(fill==w->u.bar.fill) return;
+    w->u.bar.fill = fill;
+    w->dirty = 1;
+}
+
+/** \brief Sets up an icon
+ *
+ * \param[out] w pcd8544_widget_t* Widget
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical position
+ * \param[in] bitmap uint8_t* Page-packed bitmap of width x height (kept, not copied)
+ * \param[in] width uint8_t Width
+ * \param[in] height uint8_t Height
+ *
+ */
+
+void LCDiconInit(pcd8544_widget_t *w, int16_t x, int16_t y, const uint8_t *bitmap, uint8_t width, uint8_t height)
+{
+    __widgetinit(w, LCD_WIDGET_ICON, x, y, width, height);
+    w->u.icon.bitmap = bitmap;
+}
+
+/** \brief Switches the bitmap of an icon
+ *
+ * \param[in,out] w pcd8544_widget_t* Icon
+ * \param[in] bitmap uint8_t* Page-packed bitmap of the icon's size (kept, not copied)
+ *
+ */
+
+void LCDiconSet(pcd8544_widget_t *w, const uint8_t *bitmap)
+{
+    if(bitmap==w->u.icon.bitmap) return;
+    w->u.icon.bitmap = bitmap;
+    w->dirty = 1;
+}
+
+/** \brief Sets up a sparkline
+ *
+ * \param[out] w pcd8544_widget_t* Widget
+ * \param[in] x int16_t Horizontal position
+ * \param[in] y int16_t Vertical position
+ * \param[in] width uint8_t Width, one sample per column
+ * \param[in] height uint8_t Height
+ * \param[in] min int32_t Value drawn at the bottom
+ * \param[in] max int32_t Value drawn at the top
+ *
+ */
+
+void LCDsparklineInit(pcd8544_widget_t *w, int16_t x, int16_t y, uint8_t width, uint8_t height, int32_t min, int32_t max)
+{
+    __widgetinit(w, LCD_WIDGET_SPARKLINE, x, y, width, height);
+    w->u.spark.min = min;
+    w->u.spark.max = max;
+}
+
+/** \brief Appends a sample to a sparkline, scrolling it left once full
+ *
+ * \param[in,out] w pcd8544_widget_t* Sparkline
+ * \param[in] value int32_t Sample
+ *
+ */
+
+void LCDsparklinePush(pcd8544_widget_t *w, int32_t value)
+{
+    uint8_t row, i;
+    if(!w->w||!w->h) return;
+    row = w->h-1-__scale(value, w->u.spark.min, w->u.spark.max, w->h-1);
+    if(w->u.spark.count==w->w)
+    {
+        /* a full, flat line that stays flat looks the same after scrolling */
+        for(i=0; (i<w->u.spark.count)&&(w->u.spark.rows[i]==row); ++i);
+        if(i==w->u.spark.count) return;
+        memmove(w->u.spark.rows, w->u.spark.rows+1, --w->u.spark.count);
+    }
+    w->u.spark.rows[w->u.spark.count++] = row;
+    w->dirty = 1;
+}
+
+/** \brief Sets the foreground colour of a widget
+ *
+ * \param[in,out] w pcd8544_widget_t* Widget
+ * \param[in] color uint8_t WHITE/BLACK
+ *
+ */
+
+void LCDwidgetSetColor(pcd8544_widget_t *w, uint8_t color)
+{
+    color = color?BLACK:WHITE;
+    if(color==w->color) return;
+    w->color = color;
+    w->dirty = 1;
+}